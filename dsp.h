@@ -6,9 +6,11 @@
 
 #include <math.h>
 #include <stdint.h>
+#include <atomic>
 
 namespace four {
 
+static constexpr float PI = 3.141592653589793f;
 static constexpr float TWO_PI = 6.283185307179586f;
 
 // Denormal protection: flush subnormals to zero
@@ -36,19 +38,121 @@ struct DCBlocker
     }
 };
 
-// Simple 2× downsampler (half-band average)
+// --- Sine table ---
+//
+// Phase-indexed sine table with linear interpolation, shared by the
+// oscillator and the wave folders. The size is a build-time accuracy tier
+// set with FOUR_SINE_TABLE_BITS; worst-case error is pi^2 / (2 * N^2):
+//    8 bits ( 256):  7.5e-5  (-82 dB)
+//   10 bits (1024):  4.7e-6  (-106 dB)
+//   11 bits (2048):  1.2e-6  (-118 dB)  default
+//   12 bits (4096):  2.9e-7  (-130 dB)
+// init_sine_table() must run once before any lookup.
+
+#ifndef FOUR_SINE_TABLE_BITS
+#define FOUR_SINE_TABLE_BITS 11
+#endif
+
+static constexpr int SINE_TABLE_SIZE = 1 << FOUR_SINE_TABLE_BITS;
+static constexpr int SINE_TABLE_MASK = SINE_TABLE_SIZE - 1;
+
+// One guard point so interpolation never needs to wrap
+static float sineTable[SINE_TABLE_SIZE + 1];
+
+inline void init_sine_table()
+{
+    for ( int i = 0; i <= SINE_TABLE_SIZE; ++i )
+        sineTable[i] = sinf( (float)i * ( TWO_PI / (float)SINE_TABLE_SIZE ) );
+    sineTable[SINE_TABLE_SIZE] = sineTable[0];
+}
+
+// Interpolated sine of normalized phase [0, 1]
+inline float sine_lookup( float phase )
+{
+    float pos = phase * (float)SINE_TABLE_SIZE;
+    int i = (int)pos;
+    float frac = pos - (float)i;
+    i &= SINE_TABLE_MASK;
+    float a = sineTable[i];
+    return a + frac * ( sineTable[i + 1] - a );
+}
+
+// Interpolated sine of any phase (wrapped to [0, 1) first)
+inline float sine_lookup_wrapped( float phase )
+{
+    return sine_lookup( phase - floorf( phase ) );
+}
 
 // Compute sine from normalized phase [0, 1)
 inline float oscillator_sine( float phase )
 {
-    return sinf( phase * TWO_PI );
+    return sine_lookup( phase );
 }
 
-// Advance phase by increment, wrap to [0, 1)
-inline void phase_advance( float& phase, float increment )
+// --- Phase accumulator ---
+//
+// Operator phases are 32-bit fixed point, 2^32 to the cycle. Wrapping is
+// unsigned overflow, and every step lands exactly: the resolution is
+// 1 / 2^32 of a cycle at any phase, where a float phase near 1 keeps 24
+// bits and rounds every increment the same way, so low or finely tuned
+// operators drift. Increments and PM stay float cycles and enter through
+// phase_step(); waveforms read phase_sine() or phase_to_float().
+
+typedef uint32_t Phase;
+
+// Float cycles as a phase step, rounded to the nearest 2^-32. Whole cycles
+// drop out, so a negative step (through-zero FM) runs backwards and steps
+// past Nyquist alias as before. Only exactly +half a cycle overflows int32;
+// it is held a hair below.
+inline Phase phase_step( float cycles )
 {
-    phase += increment;
-    phase -= floorf( phase );
+    float steps = rintf( ( cycles - rintf( cycles ) ) * 4294967296.0f );
+    return (Phase)(int32_t)fminf( steps, 2147483520.0f );
+}
+
+// Phase as float cycles in [0, 1), to 24 bits
+inline float phase_to_float( Phase phase )
+{
+    return (float)( phase >> 8 ) * ( 1.0f / 16777216.0f );
+}
+
+// Interpolated sine straight from a fixed-point phase: the top bits index
+// the table, the rest interpolate
+inline float phase_sine( Phase phase )
+{
+    uint32_t i = phase >> ( 32 - FOUR_SINE_TABLE_BITS );
+    float frac = (float)( ( phase << FOUR_SINE_TABLE_BITS ) >> 8 ) * ( 1.0f / 16777216.0f );
+    float a = sineTable[i];
+    return a + frac * ( sineTable[i + 1] - a );
+}
+
+// Advance phase by increment (cycles per sample). A negative increment
+// runs the phase backwards.
+inline void phase_advance( Phase& phase, float increment )
+{
+    phase += phase_step( increment );
+}
+
+// Advance a hard-synced phase through one sample. `reset` is how much of
+// the sample is left after a sync edge within it, 0-1, or negative for
+// none; the phase restarts from 0 at the edge. Returns the same measure
+// for this phase's own wrap (either direction) or reset, which is what
+// operators synced to it see.
+inline float sync_phase_advance( Phase& phase, float increment, float reset )
+{
+    if ( reset >= 0.0f )
+    {
+        phase = phase_step( increment * reset );
+        return reset;
+    }
+    Phase before = phase;
+    phase += phase_step( increment );
+    float now = phase_to_float( phase );
+    if ( increment >= 0.0f && phase < before )
+        return fminf( now / increment, 1.0f );
+    if ( increment < 0.0f && phase > before )
+        return fminf( ( now - 1.0f ) / increment, 1.0f );
+    return -1.0f;
 }
 
 // Frequency in ratio mode: base_hz * coarse_ratio * fine_multiplier
@@ -63,10 +167,59 @@ inline float calc_frequency_fixed( float coarse_hz, float fine_mult )
     return coarse_hz * fine_mult;
 }
 
+// Frequency at 0V on the V/OCT input (C4)
+static constexpr float VOCT_ZERO_HZ = 261.63f;
+
 // V/OCT to frequency. 0V = C4 (261.63Hz), 1V/octave.
 inline float voct_to_freq( float voltage )
 {
-    return 261.63f * exp2f( voltage );
+    return VOCT_ZERO_HZ * exp2f( voltage );
+}
+
+// Fast 2^x for per-sample pitch CV. The nearest integer goes straight into
+// the exponent bits; a 6th-order polynomial covers the remainder in
+// [-0.5, 0.5]. Relative error < 5e-7 (under 0.001 cent). x is clamped to
+// ±24 octaves.
+inline float fast_exp2( float x )
+{
+    x = fminf( 24.0f, fmaxf( -24.0f, x ) );
+    int i = (int)( x + 64.5f ) - 64;  // round without floorf
+    float f = x - (float)i;
+    float r = 1.0f + f * ( 0.69314718f + f * ( 0.24022651f + f * ( 0.05550411f
+                   + f * ( 0.00961813f + f * ( 0.00133336f + f * 0.00015404f ) ) ) ) );
+    union { float f; int32_t i; } u;
+    u.f = r;
+    u.i += i * ( 1 << 23 );
+    return u.f;
+}
+
+// Operator tuning as frequency = base × scale + offset, so ratio and fixed
+// operators share one branch-free expression:
+//   ratio: scale = coarse × fine × tuning,  offset = 0
+//   fixed: scale = 0,                       offset = fixedHz × fine
+// tuning carries global factors such as fine tune and pitch bend.
+inline void calc_operator_tuning(
+    const uint8_t freqMode[4],
+    const float coarse[4],
+    const float fixedHz[4],
+    const float fine[4],
+    float tuning,
+    float scale[4],
+    float offset[4] )
+{
+    for ( int op = 0; op < 4; ++op )
+    {
+        if ( freqMode[op] == 0 )  // Ratio
+        {
+            scale[op] = calc_frequency_ratio( tuning, coarse[op], fine[op] );
+            offset[op] = 0.0f;
+        }
+        else  // Fixed
+        {
+            scale[op] = 0.0f;
+            offset[op] = calc_frequency_fixed( fixedHz[op], fine[op] );
+        }
+    }
 }
 
 // MIDI note to frequency. Note 69 = A4 = 440Hz.
@@ -127,11 +280,11 @@ inline float wave_warp( float phase, float warp )
     }
 }
 
-// Soft clipping function (tanh approximation, fast)
+// Soft clipping function (tanh approximation, fast). Clamping to ±3, where
+// the curve reaches ±1, keeps it branch-free.
 inline float soft_clip( float x )
 {
-    if ( x < -3.0f ) return -1.0f;
-    if ( x >  3.0f ) return  1.0f;
+    x = fminf( fmaxf( x, -3.0f ), 3.0f );
     float x2 = x * x;
     return x * ( 27.0f + x2 ) / ( 27.0f + 9.0f * x2 );
 }
@@ -139,14 +292,14 @@ inline float soft_clip( float x )
 // Symmetric fold: sin-based fold that wraps signal back within [-1, 1]
 inline float fold_symmetric( float x )
 {
-    return sinf( x * 1.5707963f );  // sin(x * π/2)
+    return sine_lookup_wrapped( x * 0.25f );  // sin(x * π/2)
 }
 
 // Asymmetric fold: positive folds, negative clips
 inline float fold_asymmetric( float x )
 {
     if ( x >= 0.0f )
-        return sinf( x * 1.5707963f );
+        return sine_lookup_wrapped( x * 0.25f );
     else
         return soft_clip( x );
 }
@@ -170,6 +323,117 @@ inline float wave_fold( float input, float amount, int type )
     }
 }
 
+// --- Antiderivative anti-aliased folding ---
+//
+// First-order ADAA replaces f(x[n]) with the mean of f over the segment
+// from x[n-1] to x[n]: (F(x[n]) - F(x[n-1])) / (x[n] - x[n-1]), F the
+// antiderivative. That averaging is a sample-rate lowpass on the new
+// partials a fold creates, costing about one extra lookup per sample and
+// half a sample of delay. Each difference quotient is rearranged so it
+// stays well conditioned as the segment shrinks to a point.
+
+// sin(t) / t
+inline float adaa_sinc( float t )
+{
+    if ( fabsf( t ) < 0.5f )
+    {
+        float t2 = t * t;
+        return 1.0f - t2 * ( 1.0f / 6.0f ) + t2 * t2 * ( 1.0f / 120.0f );
+    }
+    return sine_lookup_wrapped( t * ( 1.0f / TWO_PI ) ) / t;
+}
+
+// log(1 + r) / r
+inline float adaa_log1p_ratio( float r )
+{
+    if ( fabsf( r ) < 1e-3f )
+        return 1.0f - r * 0.5f + r * r * ( 1.0f / 3.0f );
+    return log1pf( r ) / r;
+}
+
+// sin(πx/2) has F = -(2/π) cos(πx/2); the cosine difference factors into
+// sin(π mid / 2) × sinc(π d / 4)
+inline float fold_symmetric_adaa( float x, float x0 )
+{
+    float mid = ( x + x0 ) * 0.5f;
+    return sine_lookup_wrapped( mid * 0.25f ) * adaa_sinc( ( x - x0 ) * ( PI * 0.25f ) );
+}
+
+// Antiderivatives with F(0) = 0, for segments that cross a seam
+inline float fold_positive_antiderivative( float x )
+{
+    float s = sine_lookup_wrapped( x * 0.125f );
+    return ( 4.0f / PI ) * s * s;           // (2/π)(1 - cos(πx/2))
+}
+
+inline float soft_clip_antiderivative( float x )
+{
+    float a = fabsf( x );
+    if ( a > 3.0f )
+        return a - 0.651607f;               // F(3) - 3, continuous at ±3
+    float x2 = x * x;
+    return x2 * ( 1.0f / 18.0f ) + ( 4.0f / 3.0f ) * log1pf( x2 * ( 1.0f / 3.0f ) );
+}
+
+// soft_clip(x) = x/9 + (8/3) x / (x² + 3) inside ±3, so F is
+// x²/18 + (4/3) ln(1 + x²/3); the log difference becomes one log1p
+inline float soft_clip_adaa( float x, float x0 )
+{
+    if ( x > 3.0f && x0 > 3.0f )
+        return 1.0f;
+    if ( x < -3.0f && x0 < -3.0f )
+        return -1.0f;
+    float d = x - x0;
+    float mid = ( x + x0 ) * 0.5f;
+    if ( fabsf( x ) <= 3.0f && fabsf( x0 ) <= 3.0f )
+    {
+        float k = 2.0f * mid / ( 3.0f + x0 * x0 );
+        return mid * ( 1.0f / 9.0f ) + ( 4.0f / 3.0f ) * k * adaa_log1p_ratio( k * d );
+    }
+    // Crossing ±3: f is flat there, so the midpoint is exact enough
+    if ( fabsf( d ) < 1e-2f )
+        return soft_clip( mid );
+    return ( soft_clip_antiderivative( x ) - soft_clip_antiderivative( x0 ) ) / d;
+}
+
+inline float fold_asymmetric_adaa( float x, float x0 )
+{
+    if ( x >= 0.0f && x0 >= 0.0f )
+        return fold_symmetric_adaa( x, x0 );
+    if ( x < 0.0f && x0 < 0.0f )
+        return soft_clip_adaa( x, x0 );
+    // Crossing zero: both antiderivatives are small and positive, and
+    // |d| is at least as large as either end, so the quotient is safe
+    float d = x - x0;
+    if ( fabsf( d ) < 1e-6f )
+        return fold_asymmetric( ( x + x0 ) * 0.5f );
+    float fx = x >= 0.0f ? fold_positive_antiderivative( x ) : soft_clip_antiderivative( x );
+    float f0 = x0 >= 0.0f ? fold_positive_antiderivative( x0 ) : soft_clip_antiderivative( x0 );
+    return ( fx - f0 ) / d;
+}
+
+// wave_fold() with first-order ADAA. prev holds the previous driven
+// input, per operator and voice; it follows the input while fold is off.
+inline float wave_fold_adaa( float input, float amount, int type, float& prev )
+{
+    if ( amount <= 0.0f )
+    {
+        prev = input;
+        return input;
+    }
+
+    float driven = input * ( 1.0f + amount * 4.0f );
+    float x0 = prev;
+    prev = driven;
+
+    switch ( type )
+    {
+    case 0:  return fold_symmetric_adaa( driven, x0 );
+    case 1:  return fold_asymmetric_adaa( driven, x0 );
+    default: return soft_clip_adaa( driven, x0 );
+    }
+}
+
 struct Algorithm
 {
     bool mod[4][4];     // mod[src][dst]: src modulates dst
@@ -177,7 +441,8 @@ struct Algorithm
 };
 
 // 11 FM algorithms (0-indexed)
-static const Algorithm algorithms[11] = {
+// constexpr so per-algorithm renderers can resolve routing at compile time
+static constexpr Algorithm algorithms[11] = {
     // Algo 1: 4→3→2→1, carriers: {1}
     { { {0,0,0,0}, {1,0,0,0}, {0,1,0,0}, {0,0,1,0} },
       {true, false, false, false} },
@@ -255,26 +520,330 @@ inline float sum_carriers(
     return mix;
 }
 
-// Calculate feedback contribution from previous output
-// prev_output: previous sample output, amount: 0.0-1.0
+// An operator's last two outputs, for feedback
+struct FeedbackHistory
+{
+    float last;
+    float prior;
+
+    void push( float x ) { prior = last; last = x; }
+};
+
+// Calculate feedback contribution from previous outputs
+// amount: 0.0-1.0; average: 0 reads the last output alone, 0.5 the mean
+// of the last two (DX style), whose zero at Nyquist cancels the
+// period-two ringing that turns high feedback into noise.
 // Returns phase modulation amount (bounded)
-inline float calc_feedback( float prev_output, float amount )
+inline float calc_feedback( const FeedbackHistory& prev, float amount, float average )
+{
+    return soft_clip( ( prev.last + average * ( prev.prior - prev.last ) ) * amount );
+}
+
+// --- Half-band decimators ---
+//
+// Each stage takes 2 × frames sub-samples and writes `frames` outputs;
+// processing in place (out == in) is safe. Every stage keeps 0-20 kHz
+// (at 48 kHz output) flat and rejects whatever would alias into 0-28 kHz
+// once all later stages have run, so stages nearer the top rate get by
+// with far wider transition bands and fewer taps.
+
+// Polyphase IIR: two chains of first-order allpass sections in z^-2, each
+// running at the output rate on one phase of the input. Not linear phase,
+// but the group delay is only a couple of samples in the passband.
+template <int N>
+struct HalfbandIIR
+{
+    const float* coefs;
+    float x[N];
+    float y[N];
+
+    explicit HalfbandIIR( const float* c ) : coefs( c ) { reset(); }
+
+    void reset()
+    {
+        for ( int c = 0; c < N; ++c )
+            x[c] = y[c] = 0.0f;
+    }
+
+    void process( const float* in, float* out, int frames )
+    {
+        for ( int i = 0; i < frames; ++i )
+        {
+            float a = in[2 * i + 1];
+            float b = in[2 * i];
+            for ( int c = 0; c < N; c += 2 )
+            {
+                float ta = ( a - y[c] ) * coefs[c] + x[c];
+                float tb = ( b - y[c + 1] ) * coefs[c + 1] + x[c + 1];
+                x[c] = a;
+                y[c] = ta;
+                a = ta;
+                x[c + 1] = b;
+                y[c + 1] = tb;
+                b = tb;
+            }
+            out[i] = ( a + b ) * 0.5f;
+        }
+        // Allpass state rings down forever on silence
+        for ( int c = 0; c < N; ++c )
+            flush_denormal( y[c] );
+    }
+};
+
+// Polyphase linear-phase FIR: Kaiser-windowed half-band with 4P - 1 taps.
+// Every other tap is zero, so the even phase is a pure delay through the
+// centre tap and the odd phase is P symmetric pairs. Latency is
+// P - 0.5 output samples.
+template <int P>
+struct HalfbandFIR
+{
+    const float* coefs;
+    // Odd and even phase histories, each written twice so the newest
+    // samples are always contiguous from the write position (newest first)
+    float odd[4 * P];
+    float even[2 * P];
+    int oddPos;
+    int evenPos;
+
+    explicit HalfbandFIR( const float* c ) : coefs( c ) { reset(); }
+
+    void reset()
+    {
+        for ( int i = 0; i < 4 * P; ++i )
+            odd[i] = 0.0f;
+        for ( int i = 0; i < 2 * P; ++i )
+            even[i] = 0.0f;
+        oddPos = 0;
+        evenPos = 0;
+    }
+
+    void process( const float* in, float* out, int frames )
+    {
+        for ( int i = 0; i < frames; ++i )
+        {
+            if ( --oddPos < 0 )
+                oddPos += 2 * P;
+            if ( --evenPos < 0 )
+                evenPos += P;
+            float s0 = in[2 * i];
+            float s1 = in[2 * i + 1];
+            even[evenPos] = s0;
+            even[evenPos + P] = s0;
+            odd[oddPos] = s1;
+            odd[oddPos + 2 * P] = s1;
+
+            const float* w = odd + oddPos;
+            float acc = 0.5f * even[evenPos + P - 1];
+            for ( int k = 0; k < P; ++k )
+                acc += coefs[k] * ( w[P - 1 - k] + w[P + k] );
+            out[i] = acc;
+        }
+    }
+};
+
+// Selectable-quality stage. Only the selected filter runs; call reset()
+// when switching so the other one doesn't resume on stale state.
+enum DecimatorQuality { DECIMATE_IIR, DECIMATE_FIR };
+
+template <int IIR_COEFS, int FIR_PAIRS>
+struct HalfbandDecimator
+{
+    HalfbandIIR<IIR_COEFS> iir;
+    HalfbandFIR<FIR_PAIRS> fir;
+
+    HalfbandDecimator( const float* iirCoefs, const float* firCoefs )
+        : iir( iirCoefs ), fir( firCoefs ) {}
+
+    void reset()
+    {
+        iir.reset();
+        fir.reset();
+    }
+
+    void process( const float* in, float* out, int frames, int quality )
+    {
+        if ( quality == DECIMATE_FIR )
+            fir.process( in, out, frames );
+        else
+            iir.process( in, out, frames );
+    }
+};
+
+// 2× → 1×: transition 20-28 kHz. IIR ~96 dB, FIR 63 taps ~80 dB.
+static constexpr float halfband2xIIR[6] = {
+    0.0441819091f, 0.16418886f, 0.330744162f,
+    0.515086943f, 0.702052852f, 0.894889642f
+};
+static constexpr float halfband2xFIR[16] = {
+    0.317072851f, -0.102442502f, 0.0577240406f, -0.0374893791f,
+    0.0256376836f, -0.017804699f, 0.0123155822f, -0.00837620988f,
+    0.00554364665f, -0.00353441407f, 0.00214590843f, -0.00122207592f,
+    0.000638106334f, -0.000293560062f, 0.000109036223f, -2.40152509e-05f
+};
+
+// 4× → 2×: transition 20-68 kHz. IIR ~103 dB, FIR 23 taps ~71 dB.
+static constexpr float halfband4xIIR[4] = {
+    0.0481485738f, 0.189116489f, 0.420341678f, 0.76307429f
+};
+static constexpr float halfband4xFIR[6] = {
+    0.309502764f, -0.0822290042f, 0.0306162665f,
+    -0.00992962541f, 0.00217570993f, -0.000136111156f
+};
+
+// 8× → 4×: transition 20-164 kHz. IIR ~87 dB, FIR 15 taps ~77 dB.
+static constexpr float halfband8xIIR[2] = {
+    0.115151676f, 0.5456663f
+};
+static constexpr float halfband8xFIR[4] = {
+    0.295594005f, -0.0529562236f, 0.00749656264f, -0.000134344398f
+};
+
+struct Decimator2x : HalfbandDecimator<6, 16>
+{
+    Decimator2x() : HalfbandDecimator( halfband2xIIR, halfband2xFIR ) {}
+};
+
+struct Decimator4x : HalfbandDecimator<4, 6>
+{
+    Decimator4x() : HalfbandDecimator( halfband4xIIR, halfband4xFIR ) {}
+};
+
+struct Decimator8x : HalfbandDecimator<2, 4>
 {
-    return soft_clip( prev_output * amount );
+    Decimator8x() : HalfbandDecimator( halfband8xIIR, halfband8xFIR ) {}
+};
+
+// Decimation cascade from up to 8× down to 1×. The stages above 2× are
+// optional so callers can allocate only the ones they use; they must be
+// set before process() is asked for that factor.
+struct DecimatorChain
+{
+    Decimator2x s2;
+    Decimator4x* s4 = NULL;
+    Decimator8x* s8 = NULL;
+
+    void reset()
+    {
+        s2.reset();
+        if ( s4 )
+            s4->reset();
+        if ( s8 )
+            s8->reset();
+    }
+
+    // Decimate frames × factor sub-samples in place (factor 1, 2, 4 or 8)
+    void process( float* buf, int frames, int factor, int quality )
+    {
+        if ( factor >= 8 )
+            s8->process( buf, buf, frames * 4, quality );
+        if ( factor >= 4 )
+            s4->process( buf, buf, frames * 2, quality );
+        if ( factor >= 2 )
+            s2.process( buf, buf, frames, quality );
+    }
+};
+
+// Anti-aliasing for warped shapes: none, PolyBLEP on the saw and pulse
+// edges, or band-limited tables (see WarpTables)
+enum WarpAntialias { WARP_NAIVE, WARP_POLYBLEP, WARP_TABLE };
+
+// --- Adaptive oversampling ---
+//
+// Rough upper bound on the highest significant output frequency of a
+// patch, used to pick the lowest oversampling factor that keeps aliases
+// out of the audio band. Phase modulation widens an operator's spectrum
+// to its frequency plus (index + 1) × each modulator's extent (Carson's
+// rule), with a 1.5× margin on the index since the 98% power bandwidth
+// still leaves audible aliases. Fold, warp and feedback then multiply the
+// result, as they shape the modulated waveform. Errs high: overestimating
+// only costs CPU, and feedback patches alias badly when underestimated.
+
+// Harmonics of a sine with self-feedback, counted down to -60 dB.
+// Feedback is self-PM at index β = 2π × amount; below β = 1 the spectrum
+// falls geometrically, by r = β e^√(1-β²) / (1 + √(1-β²)) a harmonic
+// (the Kapteyn series' asymptote). Towards β = 1 r reaches 1 and the
+// wave turns saw-like, or noisy reading the last sample alone, so the
+// count is capped where further oversampling buys little.
+inline float feedback_harmonics( float amount )
+{
+    const float maxHarmonics = 64.0f;
+    float beta = TWO_PI * amount;
+    if ( beta <= 0.0f )
+        return 1.0f;
+    if ( beta >= 0.99f )
+        return maxHarmonics;
+    float s = sqrtf( 1.0f - beta * beta );
+    float r = beta * expf( s ) / ( 1.0f + s );
+    // 60 dB / ( -20 log10 r ) harmonics
+    return fminf( 1.0f - 3.0f / log10f( r ), maxHarmonics );
 }
 
-// Simple 2× downsampler (half-band average)
-// s0: first sample (even), s1: second sample (odd)
-inline float downsample_2x( float s0, float s1 )
+struct OperatorRisk
+{
+    float freq;      // Hz, highest across voices
+    float level;     // 0-1
+    float feedback;  // 0-1
+    float warp;      // 0-1
+    float fold;      // 0-1
+    uint8_t foldType;
+};
+
+inline float estimate_bandwidth( const Algorithm& a, const OperatorRisk op[4],
+                                 float xm, int warpMode )
 {
-    return ( s0 + s1 ) * 0.5f;
+    float top[4];
+    float bandwidth = 0.0f;
+    for ( int i = 3; i >= 0; --i )
+    {
+        const OperatorRisk& o = op[i];
+        top[i] = o.freq;
+        for ( int src = i + 1; src < 4; ++src )
+        {
+            float index = TWO_PI * op[src].level * xm;
+            if ( a.mod[src][i] && index > 0.0f )
+                top[i] += ( 1.5f * index + 1.0f ) * top[src];
+        }
+
+        float harmonics = 1.0f;
+        // Folding a sine with drive D acts like PM at index ~πD/2;
+        // soft clip rolls off much faster
+        if ( o.fold > 0.0f )
+            harmonics += ( o.foldType == 2 ? 0.5f : 1.5708f ) * ( 1.0f + o.fold * 4.0f );
+        // Warped shapes have edges; PolyBLEP takes most of the sting out
+        // and the tables stop at Nyquist, leaving only what PM adds
+        if ( o.warp > 0.0f )
+            harmonics += o.warp * ( warpMode == WARP_TABLE ? 2.0f
+                                  : warpMode == WARP_POLYBLEP ? 8.0f : 32.0f );
+        top[i] *= harmonics;
+
+        // Feedback steepens the wave. Heard, its harmonics reach far up
+        // (feedback_harmonics); as a modulator it's the peak slope, and
+        // so the deviation it drives, that grows, by 1 / (1 - β)
+        if ( a.carrier[i] && o.level > 0.0f )
+            bandwidth = fmaxf( bandwidth, top[i] * feedback_harmonics( o.feedback ) );
+        top[i] /= fmaxf( 1.0f - TWO_PI * o.feedback, 1.0f / 64.0f );
+    }
+    return bandwidth;
+}
+
+// Lowest factor (1, 2, 4 or 8, at most maxFactor) at which a spectrum
+// reaching `bandwidth` Hz aliases no lower than 20 kHz
+inline int choose_oversampling( float bandwidth, float sampleRate, int maxFactor )
+{
+    int factor = 1;
+    while ( factor < maxFactor && bandwidth > (float)factor * sampleRate - 20000.0f )
+        factor *= 2;
+    return factor;
 }
 
 // PolyBLEP correction for discontinuities
 // phase: normalized [0, 1), dt: phase increment per sample
-// Returns correction to subtract from waveform at discontinuity points
+// Returns correction to subtract from waveform at discontinuity points.
+// Running backwards (dt < 0) crosses the same edges in the other
+// direction; the residual flips with the jump, so only |dt| matters.
 inline float polyblep( float phase, float dt )
 {
+    dt = fabsf( dt );
     // Near phase = 0 (beginning of cycle)
     if ( phase < dt )
     {
@@ -290,6 +859,18 @@ inline float polyblep( float phase, float dt )
     return 0.0f;
 }
 
+// Band-limit a hard-sync reset: the output stepped by `step` with `after`
+// of a sample to go before out[i] (see sync_phase_advance). The polyBLEP
+// residual goes on the samples either side; out[i - 1] is left alone when
+// i == 0, as it went out with the previous block.
+inline void sync_blep( float* out, int i, float after, float step )
+{
+    float h = 0.5f * step;
+    out[i] -= h * ( 1.0f - after ) * ( 1.0f - after );
+    if ( i > 0 )
+        out[i - 1] += h * after * after;
+}
+
 // PolyBLEP-corrected saw
 inline float waveform_saw_blep( float phase, float dt )
 {
@@ -337,6 +918,1003 @@ inline float wave_warp_blep( float phase, float warp, float dt )
     }
 }
 
+// --- Band-limited warp tables ---
+//
+// Every warp position is a crossfade between two fixed shapes, so
+// band-limiting the shapes band-limits the whole morph. Triangle, saw and
+// pulse are stored as sums of their first N partials, mip-mapped in
+// half-octave steps of N; each block uses the richest level whose top
+// partial stays below Nyquist at the block's largest increment. Unlike
+// PolyBLEP this also rounds the triangle's corners. Partials pushed past
+// Nyquist by phase modulation still alias.
+
+static constexpr int WARP_TABLE_BITS = 11;
+static constexpr int WARP_TABLE_SIZE = 1 << WARP_TABLE_BITS;
+static constexpr int WARP_TABLE_STRIDE = WARP_TABLE_SIZE + 1;  // guard point
+static constexpr int WARP_TABLE_LEVELS = 19;                   // 512 partials down to 1
+
+// Partials kept at a level: 512 / 2^(level/2), rounded down
+inline int warp_table_partials( int level )
+{
+    return (int)( 512.0 * pow( 2.0, -0.5 * level ) + 1e-9 );
+}
+
+// Level for a block whose largest phase increment is maxInc
+inline int warp_table_level( float maxInc )
+{
+    if ( maxInc <= 0.0f )
+        return 0;
+    float level = ceilf( 2.0f * log2f( maxInc ) + 20.0f );
+    if ( level < 0.0f )
+        return 0;
+    return level < WARP_TABLE_LEVELS - 1 ? (int)level : WARP_TABLE_LEVELS - 1;
+}
+
+struct WarpTables
+{
+    // [level][triangle, saw, pulse][phase]
+    float shape[WARP_TABLE_LEVELS][3][WARP_TABLE_STRIDE];
+
+    // Sum the Fourier series once per point, storing the running sums as
+    // the partial count reaches each level. sin(hx) comes from the
+    // Chebyshev recurrence, in double so it stays exact over 512 steps.
+    void build()
+    {
+        const double pi = 3.14159265358979323846;
+        int partials[WARP_TABLE_LEVELS];
+        for ( int k = 0; k < WARP_TABLE_LEVELS; ++k )
+            partials[k] = warp_table_partials( k );
+
+        for ( int i = 0; i < WARP_TABLE_STRIDE; ++i )
+        {
+            double x = 2.0 * pi * i / WARP_TABLE_SIZE;
+            double c2 = 2.0 * cos( x );
+            double prev = 0.0, sn = sin( x );  // sin((h-1)x), sin(hx)
+            double tri = 0.0, saw = 0.0, pls = 0.0;
+            int k = WARP_TABLE_LEVELS - 1;
+            for ( int h = 1; k >= 0; ++h )
+            {
+                saw -= sn * 2.0 / ( pi * h );
+                if ( h & 1 )
+                {
+                    pls += sn * 4.0 / ( pi * h );
+                    tri += sn * ( h & 2 ? -8.0 : 8.0 ) / ( pi * pi * h * h );
+                }
+                for ( ; k >= 0 && partials[k] == h; --k )
+                {
+                    shape[k][0][i] = (float)tri;
+                    shape[k][1][i] = (float)saw;
+                    shape[k][2][i] = (float)pls;
+                }
+                double next = c2 * sn - prev;
+                prev = sn;
+                sn = next;
+            }
+        }
+    }
+
+    const float* level( float maxInc ) const
+    {
+        return shape[warp_table_level( maxInc )][0];
+    }
+};
+
+// Wave warp from one level of the tables (see WarpTables::level)
+inline float wave_warp_table( const float* shapes, float phase, float warp )
+{
+    if ( warp <= 0.0f )
+        return oscillator_sine( phase );
+
+    float pos = phase * (float)WARP_TABLE_SIZE;
+    int i = (int)pos;
+    float frac = pos - (float)i;
+    const float* tri = shapes + i;
+    const float* saw = tri + WARP_TABLE_STRIDE;
+    const float* pls = saw + WARP_TABLE_STRIDE;
+
+    if ( warp <= 1.0f / 3.0f )
+    {
+        float t = warp * 3.0f;
+        float sine = oscillator_sine( phase );
+        float a = tri[0] + frac * ( tri[1] - tri[0] );
+        return sine + t * ( a - sine );
+    }
+    else if ( warp <= 2.0f / 3.0f )
+    {
+        float t = ( warp - 1.0f / 3.0f ) * 3.0f;
+        float a = tri[0] + frac * ( tri[1] - tri[0] );
+        float b = saw[0] + frac * ( saw[1] - saw[0] );
+        return a + t * ( b - a );
+    }
+    else
+    {
+        float t = ( warp - 2.0f / 3.0f ) * 3.0f;
+        float a = saw[0] + frac * ( saw[1] - saw[0] );
+        float b = pls[0] + frac * ( pls[1] - pls[0] );
+        return a + t * ( b - a );
+    }
+}
+
+// Warp one sample in the anti-aliasing mode chosen at compile time
+template <int WARP>
+inline float warp_sample( float phase, float warp, float inc, const float* shapes )
+{
+    if ( WARP == WARP_TABLE )
+        return wave_warp_table( shapes, phase, warp );
+    if ( WARP == WARP_POLYBLEP )
+        return wave_warp_blep( phase, warp, inc );
+    return wave_warp( phase, warp );
+}
+
+// --- Block rendering ---
+//
+// Operators are rendered one at a time over a block of sub-samples into
+// contiguous buffers instead of interleaving all four per sample. Routing
+// always flows from higher- to lower-numbered operators, so rendering 4→1
+// finds every modulator's block complete before its targets need it.
+
+static constexpr int BLOCK_SIZE = 32;  // max sub-samples per render block
+
+// Per-operator controls for one block. Arrays hold one value per
+// sub-sample; a NULL warp/fold array means the constant applies to the
+// whole block, which lets the loops below pick a fixed path up front.
+struct OperatorBlock
+{
+    const float* inc;    // phase increment, always filled
+    const float* warp;   // NULL → warpConst
+    const float* fold;   // NULL → foldConst
+    float warpConst;
+    float foldConst;
+    float feedback;      // 0.0-1.0
+    float feedbackAverage = 0.0f;  // see calc_feedback
+    uint8_t foldType;    // 0-2
+    uint8_t warpMode;    // WarpAntialias
+    const WarpTables* warpTables;  // WARP_TABLE only
+    float* foldHistory;  // ADAA fold state for this voice, NULL = plain fold
+    const float* sync = NULL;  // hard-sync resets (see sync_phase_advance), NULL = none
+    float* wraps = NULL;       // receives this phase's wraps for synced operators
+};
+
+// Controls for rendering all four operators over one block
+struct AlgorithmBlock
+{
+    int n;                    // sub-samples, at most BLOCK_SIZE
+    const float* xm;          // always filled
+    const float* level[4];    // effective level, always filled
+    float* pm[4];             // external PM in, routing PM added in place
+    OperatorBlock op[4];
+};
+
+// Scratch buffers for one block
+struct BlockScratch
+{
+    float inc[4][BLOCK_SIZE];
+    float level[4][BLOCK_SIZE];
+    float pm[4][BLOCK_SIZE];
+    float warp[4][BLOCK_SIZE];
+    float fold[4][BLOCK_SIZE];
+    float pmCV[4][BLOCK_SIZE];  // external PM, copied into pm per voice
+    float sync[BLOCK_SIZE];     // Sync CV resets per sub-sample
+    float wrap[4][BLOCK_SIZE];  // each operator's wraps, for operators synced to it
+    float xm[BLOCK_SIZE];
+    float pitch[BLOCK_SIZE];    // per frame, V/OCT
+    float vca[BLOCK_SIZE];      // per frame, global VCA
+    float syncEdge[BLOCK_SIZE]; // per frame, Sync CV edges (see sync_edges)
+    float opOut[4][BLOCK_SIZE];
+    float mix[BLOCK_SIZE];      // one voice
+    float sum[BLOCK_SIZE];      // all voices
+};
+
+inline void block_fill( float* dst, float value, int n )
+{
+    for ( int i = 0; i < n; ++i )
+        dst[i] = value;
+}
+
+inline void block_add( float* dst, const float* src, int n )
+{
+    for ( int i = 0; i < n; ++i )
+        dst[i] += src[i];
+}
+
+// Linear ramp ending exactly on `to` at the last sub-sample
+inline void block_ramp( float* dst, float from, float to, int n )
+{
+    float delta = ( to - from ) / (float)n;
+    for ( int i = 0; i < n; ++i )
+        dst[i] = from + delta * (float)( i + 1 );
+}
+
+// Multiply by a linear ramp ending exactly on `to` at the last sample
+inline void block_mul_ramp( float* dst, float from, float to, int n )
+{
+    float delta = ( to - from ) / (float)n;
+    for ( int i = 0; i < n; ++i )
+        dst[i] *= from + delta * (float)( i + 1 );
+}
+
+// Expand frame-rate CV into sub-samples: base + cv * scale, each value
+// repeated `rate` times
+inline void block_from_cv( float* dst, const float* cv, int frames, int rate,
+                           float base, float scale )
+{
+    for ( int i = 0; i < frames; ++i )
+    {
+        float v = base + cv[i] * scale;
+        for ( int os = 0; os < rate; ++os )
+            *dst++ = v;
+    }
+}
+
+// Add frame-rate CV × scale to each sub-sample, clamped to [0, 1]
+inline void block_add_cv_clamped( float* dst, const float* cv, int frames, int rate,
+                                  float scale )
+{
+    for ( int i = 0; i < frames; ++i )
+    {
+        float c = cv[i] * scale;
+        for ( int os = 0; os < rate; ++os, ++dst )
+            *dst = fminf( 1.0f, fmaxf( 0.0f, *dst + c ) );
+    }
+}
+
+// Hard-sync edges in frame-rate CV: where it rises through `threshold`
+// between frames, dst holds how far into the frame it crossed, 0-1, found
+// by linear interpolation; negative elsewhere. prev is the reading before
+// cv[0] and is updated. Returns the number of edges.
+inline int sync_edges( float* dst, const float* cv, float& prev, int frames, float threshold )
+{
+    int edges = 0;
+    for ( int j = 0; j < frames; ++j )
+    {
+        float x = cv[j];
+        dst[j] = -1.0f;
+        if ( x > threshold && prev <= threshold )
+        {
+            dst[j] = ( threshold - prev ) / ( x - prev );
+            ++edges;
+        }
+        prev = x;
+    }
+    return edges;
+}
+
+// Expand frame sync edges into resets for sync_phase_advance(), `rate`
+// sub-samples a frame
+inline void block_from_sync_edges( float* dst, const float* edges, int frames, int rate )
+{
+    block_fill( dst, -1.0f, frames * rate );
+    for ( int j = 0; j < frames; ++j )
+    {
+        if ( edges[j] < 0.0f )
+            continue;
+        float at = edges[j] * (float)rate;
+        int k = (int)at;
+        dst[j * rate + k] = (float)( k + 1 ) - at;
+    }
+}
+
+// --- Parameter smoothing ---
+//
+// Targets are set from parameterChanged()/MIDI; step() advances each value
+// once per block and ramps linearly between block endpoints. Linear mode
+// reaches the target in `time` seconds; one-pole mode approaches it with
+// time constant `time`. A value at rest costs one comparison per block.
+struct SmoothedValue
+{
+    float value = 0.0f;
+    float target = 0.0f;
+    float rate = 0.0f;     // linear mode: units per second
+    float time = 0.0f;     // seconds
+    bool onePole = false;
+
+    void reset( float v )
+    {
+        value = target = v;
+    }
+
+    void set( float t, float seconds )
+    {
+        target = t;
+        time = seconds;
+        if ( seconds <= 0.0f )
+            value = t;
+        rate = seconds > 0.0f ? fabsf( t - value ) / seconds : 0.0f;
+    }
+
+    bool moving() const
+    {
+        return value != target;
+    }
+
+    // Move toward target by dt seconds, returns the new value
+    float advance( float dt )
+    {
+        if ( onePole )
+        {
+            float k = dt / time;
+            if ( k >= 1.0f || fabsf( target - value ) < 1e-5f )
+                value = target;
+            else
+                value += ( target - value ) * k;
+        }
+        else
+        {
+            float d = rate * dt;
+            if ( fabsf( target - value ) <= d )
+                value = target;
+            else
+                value += value < target ? d : -d;
+        }
+        return value;
+    }
+
+    // Value for a block-rate consumer
+    float block( float dt )
+    {
+        return moving() ? advance( dt ) : value;
+    }
+
+    // Fill a sub-sample block: a ramp while moving, else the constant
+    void fill( float* dst, float dt, int n )
+    {
+        if ( moving() )
+        {
+            float from = value;
+            block_ramp( dst, from, advance( dt ), n );
+        }
+        else
+            block_fill( dst, value, n );
+    }
+};
+
+// One sample of an operator's shape at a modulated phase, plain fold
+template <int WARP>
+inline float operator_shape( const OperatorBlock& b, int i, Phase phase, const float* shapes )
+{
+    float warp = b.warp ? b.warp[i] : b.warpConst;
+    float fold = b.fold ? b.fold[i] : b.foldConst;
+    float sample = warp > 0.0f ? warp_sample<WARP>( phase_to_float( phase ), warp, b.inc[i], shapes )
+                               : phase_sine( phase );
+    return fold > 0.0f ? wave_fold( sample, fold, b.foldType ) : sample;
+}
+
+// Render one operator over a block
+// pm: phase modulation per sub-sample (routing + CV, excluding feedback)
+// WARP selects the warp anti-aliasing at compile time; b.warpMode is ignored.
+// A hard-sync reset is band-limited with sync_blep(), its step taken from
+// the shape at the phase reached at the edge and at the restart. The step
+// always uses the plain fold: with Fold AA = ADAA the rendered samples are
+// averages of the fold along the input's path, so the residual is sized for
+// the static curve and leaves a small error beside the edge. With
+// feedback, the sample before the edge is corrected after it has already
+// fed the edge sample's phase; the history is patched so later samples and
+// the next block see what was emitted.
+template <int WARP>
+inline void render_operator_block(
+    Phase& phase,
+    FeedbackHistory& prevOutput,
+    const OperatorBlock& b,
+    const float* pm,
+    float* out,
+    int n )
+{
+    if ( n <= 0 )
+        return;
+
+    // One table level for the whole block, from its highest pitch
+    const float* shapes = NULL;
+    if ( WARP == WARP_TABLE && ( b.warp || b.warpConst > 0.0f ) )
+    {
+        float maxInc = 0.0f;
+        for ( int i = 0; i < n; ++i )
+            maxInc = fmaxf( maxInc, fabsf( b.inc[i] ) );
+        shapes = b.warpTables->level( maxInc );
+    }
+
+    bool synced = b.sync || b.wraps;
+
+    if ( b.feedback > 0.0f )
+    {
+        // Feedback couples each sub-sample to the previous outputs: run serially
+        FeedbackHistory prev = prevOutput;
+        for ( int i = 0; i < n; ++i )
+        {
+            float reset = b.sync ? b.sync[i] : -1.0f;
+            Phase before = phase;
+            if ( synced )
+            {
+                float wrap = sync_phase_advance( phase, b.inc[i], reset );
+                if ( b.wraps )
+                    b.wraps[i] = wrap;
+            }
+            else
+                phase_advance( phase, b.inc[i] );
+            Phase fb = phase_step( pm[i] + calc_feedback( prev, b.feedback, b.feedbackAverage ) );
+            Phase modPhase = phase + fb;
+
+            float warp = b.warp ? b.warp[i] : b.warpConst;
+            float fold = b.fold ? b.fold[i] : b.foldConst;
+            float sample;
+            if ( warp > 0.0f )
+                sample = warp_sample<WARP>( phase_to_float( modPhase ), warp, b.inc[i], shapes );
+            else
+                sample = phase_sine( modPhase );
+            if ( b.foldHistory )
+                sample = wave_fold_adaa( sample, fold, b.foldType, *b.foldHistory );
+            else if ( fold > 0.0f )
+                sample = wave_fold( sample, fold, b.foldType );
+
+            out[i] = sample;
+            if ( reset >= 0.0f )
+            {
+                // The step at the edge: from the phase reached to the restart
+                Phase reached = before + phase_step( b.inc[i] * ( 1.0f - reset ) ) + fb;
+                sync_blep( out, i, reset, operator_shape<WARP>( b, i, fb, shapes )
+                                          - operator_shape<WARP>( b, i, reached, shapes ) );
+                if ( i > 0 )
+                    prev.last = out[i - 1];
+            }
+            prev.push( out[i] );
+        }
+        prevOutput = prev;
+        return;
+    }
+
+    // Phase pass: accumulate and add modulation, wrapping for free. Sync
+    // resets are noted with the phase reached at the edge.
+    Phase ph = phase;
+    Phase mod[BLOCK_SIZE];
+    int edges = 0;
+    int edgeAt[BLOCK_SIZE];
+    Phase edgeReached[BLOCK_SIZE];
+    if ( synced )
+    {
+        for ( int i = 0; i < n; ++i )
+        {
+            float reset = b.sync ? b.sync[i] : -1.0f;
+            Phase before = ph;
+            float wrap = sync_phase_advance( ph, b.inc[i], reset );
+            if ( b.wraps )
+                b.wraps[i] = wrap;
+            mod[i] = ph + phase_step( pm[i] );
+            if ( reset >= 0.0f )
+            {
+                edgeAt[edges] = i;
+                edgeReached[edges++] = before + phase_step( b.inc[i] * ( 1.0f - reset ) )
+                                       + phase_step( pm[i] );
+            }
+        }
+    }
+    else
+    {
+        for ( int i = 0; i < n; ++i )
+        {
+            ph += phase_step( b.inc[i] );
+            mod[i] = ph + phase_step( pm[i] );
+        }
+    }
+    phase = ph;
+
+    // Waveform pass
+    if ( b.warp )
+    {
+        for ( int i = 0; i < n; ++i )
+            out[i] = warp_sample<WARP>( phase_to_float( mod[i] ), b.warp[i], b.inc[i], shapes );
+    }
+    else if ( b.warpConst > 0.0f )
+    {
+        for ( int i = 0; i < n; ++i )
+            out[i] = warp_sample<WARP>( phase_to_float( mod[i] ), b.warpConst, b.inc[i], shapes );
+    }
+    else
+    {
+        for ( int i = 0; i < n; ++i )
+            out[i] = phase_sine( mod[i] );
+    }
+
+    // Fold pass
+    if ( b.foldHistory )
+    {
+        float history = *b.foldHistory;
+        for ( int i = 0; i < n; ++i )
+            out[i] = wave_fold_adaa( out[i], b.fold ? b.fold[i] : b.foldConst, b.foldType, history );
+        *b.foldHistory = history;
+    }
+    else if ( b.fold )
+    {
+        for ( int i = 0; i < n; ++i )
+            out[i] = wave_fold( out[i], b.fold[i], b.foldType );
+    }
+    else if ( b.foldConst > 0.0f )
+    {
+        float drive = 1.0f + b.foldConst * 4.0f;
+        switch ( b.foldType )
+        {
+        case 0:
+            for ( int i = 0; i < n; ++i )
+                out[i] = fold_symmetric( out[i] * drive );
+            break;
+        case 1:
+            for ( int i = 0; i < n; ++i )
+                out[i] = fold_asymmetric( out[i] * drive );
+            break;
+        default:
+            for ( int i = 0; i < n; ++i )
+                out[i] = soft_clip( out[i] * drive );
+            break;
+        }
+    }
+
+    for ( int e = 0; e < edges; ++e )
+    {
+        int i = edgeAt[e];
+        sync_blep( out, i, b.sync[i], operator_shape<WARP>( b, i, phase_step( pm[i] ), shapes )
+                                      - operator_shape<WARP>( b, i, edgeReached[e], shapes ) );
+    }
+
+    prevOutput.prior = n > 1 ? out[n - 2] : prevOutput.last;
+    prevOutput.last = out[n - 1];
+}
+
+// As above, anti-aliasing chosen at runtime from b.warpMode
+inline void render_operator_block(
+    Phase& phase,
+    FeedbackHistory& prevOutput,
+    const OperatorBlock& b,
+    const float* pm,
+    float* out,
+    int n )
+{
+    switch ( b.warpMode )
+    {
+    case WARP_POLYBLEP:
+        render_operator_block<WARP_POLYBLEP>( phase, prevOutput, b, pm, out, n );
+        break;
+    case WARP_TABLE:
+        render_operator_block<WARP_TABLE>( phase, prevOutput, b, pm, out, n );
+        break;
+    default:
+        render_operator_block<WARP_NAIVE>( phase, prevOutput, b, pm, out, n );
+        break;
+    }
+}
+
+// Render all four operators through an algorithm and sum the carriers
+// (carrier levels applied, no VCA) into mix
+inline void render_algorithm_block(
+    const Algorithm& algo,
+    Phase phase[4],
+    FeedbackHistory prevOutput[4],
+    const AlgorithmBlock& b,
+    float opOut[4][BLOCK_SIZE],
+    float* mix )
+{
+    int n = b.n;
+
+    for ( int op = 3; op >= 0; --op )
+    {
+        // Modulators are always higher-numbered than their targets
+        float* pm = b.pm[op];
+        for ( int src = op + 1; src < 4; ++src )
+        {
+            if ( !algo.mod[src][op] )
+                continue;
+            const float* mod = opOut[src];
+            const float* level = b.level[src];
+            for ( int i = 0; i < n; ++i )
+                pm[i] += mod[i] * level[i] * b.xm[i];
+        }
+
+        render_operator_block( phase[op], prevOutput[op], b.op[op], pm, opOut[op], n );
+    }
+
+    block_fill( mix, 0.0f, n );
+    for ( int op = 0; op < 4; ++op )
+    {
+        if ( !algo.carrier[op] )
+            continue;
+        const float* level = b.level[op];
+        for ( int i = 0; i < n; ++i )
+            mix[i] += opOut[op][i] * level[i];
+    }
+}
+
+// --- Voices ---
+
+// Pick a voice for a new note: the voice already holding it, else the
+// quietest released voice (idle voices have amp 0), else the oldest held
+// voice. Ties go to the oldest. age is a wrapping note-on counter.
+inline int allocate_voice(
+    uint8_t newNote,
+    const uint8_t* note,
+    const uint8_t* gate,
+    const float* amp,
+    const uint32_t* age,
+    int numVoices )
+{
+    for ( int v = 0; v < numVoices; ++v )
+    {
+        if ( gate[v] && note[v] == newNote )
+            return v;
+    }
+
+    int best = -1;
+    for ( int v = 0; v < numVoices; ++v )
+    {
+        if ( gate[v] )
+            continue;
+        if ( best < 0 || amp[v] < amp[best] ||
+             ( amp[v] == amp[best] && (int32_t)( age[v] - age[best] ) < 0 ) )
+            best = v;
+    }
+    if ( best >= 0 )
+        return best;
+
+    best = 0;
+    for ( int v = 1; v < numVoices; ++v )
+    {
+        if ( (int32_t)( age[v] - age[best] ) < 0 )
+            best = v;
+    }
+    return best;
+}
+
+// Gate ramp for polyphonic voices: a short linear attack/release so notes
+// start and stop without clicks (Four has no envelope of its own)
+struct VoiceRamp
+{
+    float step;  // per sub-sample
+
+    explicit VoiceRamp( float sampleRate, float seconds = 0.005f )
+        : step( 1.0f / ( seconds * sampleRate ) ) {}
+
+    // Add src × ramp into dst, moving amp toward the gate over n
+    // sub-samples. Returns the new amp.
+    float apply( float* dst, const float* src, float amp, bool gate, int n ) const
+    {
+        float end = advance( amp, gate, n );
+        if ( end == amp )
+        {
+            for ( int i = 0; i < n; ++i )
+                dst[i] += src[i] * amp;
+            return amp;
+        }
+        float delta = ( end - amp ) / (float)n;
+        for ( int i = 0; i < n; ++i )
+            dst[i] += src[i] * ( amp + delta * (float)( i + 1 ) );
+        return end;
+    }
+
+    // Where apply() leaves amp after n sub-samples, without rendering
+    float advance( float amp, bool gate, int n ) const
+    {
+        return gate ? fminf( 1.0f, amp + step * (float)n )
+                    : fmaxf( 0.0f, amp - step * (float)n );
+    }
+};
+
+// --- Per-algorithm renderers ---
+//
+// render_algorithm_block() tests the routing table for every operator pair
+// on every block. The templates below resolve the table at compile time:
+// each (algorithm, warp anti-aliasing) pair gets its own fully unrolled renderer
+// with no routing branches, no loops over absent connections, and no
+// work for operators that reach neither a carrier nor another operator.
+// Oversampling only changes the block length, so it needs no variant.
+
+// True if op feeds a carrier or another operator in algorithm A
+constexpr bool operator_used( int a, int op, int dst = 0 )
+{
+    return algorithms[a].carrier[op] ||
+           ( dst < 4 && ( algorithms[a].mod[op][dst] || operator_used( a, op, dst + 1 ) ) );
+}
+
+// Add SRC's scaled output into OP's PM buffer, for SRC..3
+template <int A, int OP, int SRC>
+struct GatherModulation
+{
+    static inline void run( const AlgorithmBlock& b, float opOut[4][BLOCK_SIZE] )
+    {
+        if ( algorithms[A].mod[SRC][OP] )
+        {
+            float* pm = b.pm[OP];
+            const float* mod = opOut[SRC];
+            const float* level = b.level[SRC];
+            for ( int i = 0; i < b.n; ++i )
+                pm[i] += mod[i] * level[i] * b.xm[i];
+        }
+        GatherModulation<A, OP, SRC + 1>::run( b, opOut );
+    }
+};
+
+template <int A, int OP>
+struct GatherModulation<A, OP, 4>
+{
+    static inline void run( const AlgorithmBlock&, float[4][BLOCK_SIZE] ) {}
+};
+
+// Render OP..0 in routing order
+template <int A, int WARP, int OP>
+struct RenderOperators
+{
+    static inline void run( Phase phase[4], FeedbackHistory prevOutput[4],
+                            const AlgorithmBlock& b, float opOut[4][BLOCK_SIZE] )
+    {
+        if ( operator_used( A, OP ) )
+        {
+            GatherModulation<A, OP, OP + 1>::run( b, opOut );
+            render_operator_block<WARP>( phase[OP], prevOutput[OP], b.op[OP],
+                                         b.pm[OP], opOut[OP], b.n );
+        }
+        RenderOperators<A, WARP, OP - 1>::run( phase, prevOutput, b, opOut );
+    }
+};
+
+template <int A, int WARP>
+struct RenderOperators<A, WARP, -1>
+{
+    static inline void run( Phase*, FeedbackHistory*, const AlgorithmBlock&, float[4][BLOCK_SIZE] ) {}
+};
+
+// Add carriers OP..3 into mix
+template <int A, int OP>
+struct MixCarriers
+{
+    static inline void run( const AlgorithmBlock& b, float opOut[4][BLOCK_SIZE], float* mix )
+    {
+        if ( algorithms[A].carrier[OP] )
+        {
+            const float* level = b.level[OP];
+            for ( int i = 0; i < b.n; ++i )
+                mix[i] += opOut[OP][i] * level[i];
+        }
+        MixCarriers<A, OP + 1>::run( b, opOut, mix );
+    }
+};
+
+template <int A>
+struct MixCarriers<A, 4>
+{
+    static inline void run( const AlgorithmBlock&, float[4][BLOCK_SIZE], float* ) {}
+};
+
+// Same contract as render_algorithm_block, routing fixed to algorithms[A]
+template <int A, int WARP>
+void render_algorithm_fixed(
+    Phase phase[4],
+    FeedbackHistory prevOutput[4],
+    const AlgorithmBlock& b,
+    float opOut[4][BLOCK_SIZE],
+    float* mix )
+{
+    RenderOperators<A, WARP, 3>::run( phase, prevOutput, b, opOut );
+    block_fill( mix, 0.0f, b.n );
+    MixCarriers<A, 0>::run( b, opOut, mix );
+}
+
+typedef void (*AlgorithmRenderer)(
+    Phase phase[4],
+    FeedbackHistory prevOutput[4],
+    const AlgorithmBlock& b,
+    float opOut[4][BLOCK_SIZE],
+    float* mix );
+
+// [algorithm][WarpAntialias]
+static const AlgorithmRenderer algorithmRenderers[11][3] = {
+    { render_algorithm_fixed<0,  WARP_NAIVE>, render_algorithm_fixed<0,  WARP_POLYBLEP>,
+      render_algorithm_fixed<0,  WARP_TABLE> },
+    { render_algorithm_fixed<1,  WARP_NAIVE>, render_algorithm_fixed<1,  WARP_POLYBLEP>,
+      render_algorithm_fixed<1,  WARP_TABLE> },
+    { render_algorithm_fixed<2,  WARP_NAIVE>, render_algorithm_fixed<2,  WARP_POLYBLEP>,
+      render_algorithm_fixed<2,  WARP_TABLE> },
+    { render_algorithm_fixed<3,  WARP_NAIVE>, render_algorithm_fixed<3,  WARP_POLYBLEP>,
+      render_algorithm_fixed<3,  WARP_TABLE> },
+    { render_algorithm_fixed<4,  WARP_NAIVE>, render_algorithm_fixed<4,  WARP_POLYBLEP>,
+      render_algorithm_fixed<4,  WARP_TABLE> },
+    { render_algorithm_fixed<5,  WARP_NAIVE>, render_algorithm_fixed<5,  WARP_POLYBLEP>,
+      render_algorithm_fixed<5,  WARP_TABLE> },
+    { render_algorithm_fixed<6,  WARP_NAIVE>, render_algorithm_fixed<6,  WARP_POLYBLEP>,
+      render_algorithm_fixed<6,  WARP_TABLE> },
+    { render_algorithm_fixed<7,  WARP_NAIVE>, render_algorithm_fixed<7,  WARP_POLYBLEP>,
+      render_algorithm_fixed<7,  WARP_TABLE> },
+    { render_algorithm_fixed<8,  WARP_NAIVE>, render_algorithm_fixed<8,  WARP_POLYBLEP>,
+      render_algorithm_fixed<8,  WARP_TABLE> },
+    { render_algorithm_fixed<9,  WARP_NAIVE>, render_algorithm_fixed<9,  WARP_POLYBLEP>,
+      render_algorithm_fixed<9,  WARP_TABLE> },
+    { render_algorithm_fixed<10, WARP_NAIVE>, render_algorithm_fixed<10, WARP_POLYBLEP>,
+      render_algorithm_fixed<10, WARP_TABLE> },
+};
+
+inline AlgorithmRenderer select_renderer( int algorithm, int warpMode )
+{
+    return algorithmRenderers[algorithm][warpMode];
+}
+
+// --- Event queues ---
+//
+// Lock-free single-producer / single-consumer ring. The producer pushes;
+// the consumer reads what is pending by index from the oldest, then
+// releases it. head and tail run freely and wrap, so N must be a power of
+// two.
+template <typename T, int N>
+struct EventRing
+{
+    static_assert( ( N & ( N - 1 ) ) == 0, "EventRing size must be a power of two" );
+
+    T items[N];
+    std::atomic<uint32_t> head{ 0 };  // written by the producer only
+    std::atomic<uint32_t> tail{ 0 };  // written by the consumer only
+
+    bool push( const T& item )
+    {
+        uint32_t h = head.load( std::memory_order_relaxed );
+        if ( h - tail.load( std::memory_order_acquire ) == (uint32_t)N )
+            return false;
+        items[h & ( N - 1 )] = item;
+        head.store( h + 1, std::memory_order_release );
+        return true;
+    }
+
+    // Free slots, for a producer that must push a batch whole
+    uint32_t space() const
+    {
+        uint32_t used = head.load( std::memory_order_relaxed ) - tail.load( std::memory_order_acquire );
+        return (uint32_t)N - used;
+    }
+
+    // Consumer side
+    uint32_t pending() const
+    {
+        return head.load( std::memory_order_acquire ) - tail.load( std::memory_order_relaxed );
+    }
+    const T& operator[]( uint32_t i ) const
+    {
+        return items[( tail.load( std::memory_order_relaxed ) + i ) & ( N - 1 )];
+    }
+    void release( uint32_t n )
+    {
+        tail.store( tail.load( std::memory_order_relaxed ) + n, std::memory_order_release );
+    }
+};
+
+// Parameter updates. MIDI pushes; step() drains once per block and applies
+// each parameter once, with its latest value, in the order of that last
+// update. A push that finds the ring full goes to its parameter's overflow
+// slot instead, which keeps only the newest value: a burst longer than the
+// ring loses intermediate values, never a parameter's final one.
+template <int N>
+struct ParamQueue
+{
+    struct Event
+    {
+        uint8_t param;
+        int16_t value;
+    };
+
+    EventRing<Event, N> ring;
+    std::atomic<int16_t> overflow[256];      // latest value per parameter
+    std::atomic<uint32_t> overflowed[8];     // bit set: overflow[] holds a value
+    uint32_t spilled = 0;    // producer: pushes that found the ring full
+    uint32_t coalesced = 0;  // consumer: ring events superseded before applying
+
+    ParamQueue()
+    {
+        for ( int i = 0; i < 256; ++i )
+            overflow[i].store( 0, std::memory_order_relaxed );
+        for ( int i = 0; i < 8; ++i )
+            overflowed[i].store( 0, std::memory_order_relaxed );
+    }
+
+    // Returns false when the ring was full and the value went to the
+    // parameter's overflow slot
+    bool push( int param, int16_t value )
+    {
+        Event e = { (uint8_t)param, value };
+        if ( ring.push( e ) )
+            return true;
+        overflow[e.param].store( value, std::memory_order_relaxed );
+        overflowed[e.param >> 5].fetch_or( 1u << ( e.param & 31 ), std::memory_order_release );
+        ++spilled;
+        return false;
+    }
+
+    // Call apply( param, value ) once per pending parameter; returns the
+    // number applied. Overflowed parameters come last, in index order: the
+    // ring was full when they arrived, so they are newer than all of it.
+    template <typename F>
+    int drain( F apply )
+    {
+        // Take the overflow bits before reading the ring: the ring cannot
+        // move while it is full, so every event older than an overflowed
+        // value is among the n pending
+        uint32_t seen[8];
+        bool spill = false;
+        for ( int w = 0; w < 8; ++w )
+        {
+            seen[w] = overflowed[w].exchange( 0, std::memory_order_acquire );
+            spill |= seen[w] != 0;
+        }
+        uint32_t n = ring.pending();
+        if ( n == 0 && !spill )
+            return 0;
+        uint32_t spillBits[8];
+        for ( int w = 0; w < 8; ++w )
+            spillBits[w] = seen[w];
+
+        // Newest first: only the first sighting of a parameter survives
+        bool latest[N];
+        for ( uint32_t i = n; i-- > 0; )
+        {
+            uint8_t param = ring[i].param;
+            uint32_t bit = 1u << ( param & 31 );
+            latest[i] = !( seen[param >> 5] & bit );
+            seen[param >> 5] |= bit;
+        }
+
+        int applied = 0;
+        for ( uint32_t i = 0; i < n; ++i )
+        {
+            if ( !latest[i] )
+                continue;
+            apply( ring[i].param, ring[i].value );
+            ++applied;
+        }
+        coalesced += n - applied;
+        ring.release( n );
+
+        for ( int w = 0; w < 8; ++w )
+        {
+            for ( uint32_t bits = spillBits[w]; bits; bits &= bits - 1 )
+            {
+                int param = w * 32 + __builtin_ctz( bits );
+                apply( param, overflow[param].load( std::memory_order_relaxed ) );
+                ++applied;
+            }
+        }
+        return applied;
+    }
+};
+
+// --- Profiling ---
+//
+// Rolling cost of one processing stage, in counter ticks per output
+// sample. Each step() adds its ticks; every window the spread of the
+// per-step figures is published as min / avg / max.
+struct CpuMeter
+{
+    // Last completed window
+    float min = 0.0f;
+    float avg = 0.0f;
+    float max = 0.0f;
+
+    // Window in progress
+    uint64_t ticks = 0;
+    uint32_t frames = 0;
+    float lo = 0.0f;
+    float hi = 0.0f;
+
+    void add( uint32_t stepTicks, int stepFrames )
+    {
+        float per = (float)stepTicks / (float)stepFrames;
+        if ( frames == 0 || per < lo ) lo = per;
+        if ( frames == 0 || per > hi ) hi = per;
+        ticks += stepTicks;
+        frames += stepFrames;
+    }
+
+    void publish()
+    {
+        if ( frames == 0 )
+            return;
+        min = lo;
+        avg = (float)ticks / (float)frames;
+        max = hi;
+        ticks = 0;
+        frames = 0;
+    }
+};
+
 } // namespace four
 
 #endif // FOUR_DSP_H
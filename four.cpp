@@ -1,83 +1,330 @@
 #include <new>
 #include <math.h>
 #include <string.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#elif !defined(__arm__)
+#include <time.h>
+#endif
 #include <distingnt/api.h>
+#include <distingnt/serialisation.h>
 #include "dsp.h"
 
+// --- Profiling ---
+
+// Free-running counter for the CPU meters: the DWT cycle counter on the
+// Cortex-M7, the TSC on x86 hosts, nanoseconds elsewhere. Only differences
+// are used, so wrapping is harmless.
+#if defined(__arm__)
+static void enableCycleCounter()
+{
+    volatile uint32_t* demcr   = (volatile uint32_t*)0xE000EDFC;
+    volatile uint32_t* dwtLar  = (volatile uint32_t*)0xE0001FB0;
+    volatile uint32_t* dwtCtrl = (volatile uint32_t*)0xE0001000;
+    if ( *dwtCtrl & 1 )
+        return;               // already running
+    *demcr |= 1u << 24;       // TRCENA
+    *dwtLar = 0xC5ACCE55;     // unlock DWT
+    *dwtCtrl |= 1;            // CYCCNTENA
+}
+static inline uint32_t cycleCount() { return *(volatile uint32_t*)0xE0001004; }
+#elif defined(__x86_64__) || defined(__i386__)
+static void enableCycleCounter() {}
+static inline uint32_t cycleCount() { return (uint32_t)__rdtsc(); }
+#else
+static void enableCycleCounter() {}
+static inline uint32_t cycleCount()
+{
+    timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (uint32_t)( (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec );
+}
+#endif
+
+// Stages timed in step(); kCpuTotal covers the whole call
+enum { kCpuOperators, kCpuDecimation, kCpuOutput, kCpuTotal, kNumCpuStages };
+static const float kCpuWindowSeconds = 0.5f;
+
+// Below this (about -120 dB) a silent block's tail counts as decayed
+static const float kIdleLevel = 1e-6f;
+
+// --- Voice pool ---
+
+// Per-voice state, one array per field, allocated after _fourAlgorithm in
+// SRAM so memory scales with the "Voices" specification.
+struct VoicePool
+{
+    four::Phase (*phase)[4]; // Oscillator phases, fixed point
+    four::FeedbackHistory (*prevOutput)[4];  // Last outputs, for feedback
+    float (*inc)[4];         // Cached phase increments (constant pitch)
+    float (*foldHistory)[4]; // Previous driven fold input, for ADAA
+    four::Phase (*fadePhase)[4]; // Copies rendered at the old factor while
+    four::FeedbackHistory (*fadePrevOutput)[4];  // an oversampling change crossfades
+    float (*fadeFoldHistory)[4];
+    float* frequency;        // Hz, from MIDI note; moves while gliding
+    float* glideTo;          // Hz, the note being glided to
+    float* glide;            // per-frame pitch ratio, 1 = settled
+    float* amp;              // Gate ramp 0.0-1.0 (polyphonic only)
+    float* fadeAmp;
+    uint32_t* age;           // Note-on order, for stealing
+    uint8_t* note;           // MIDI note number
+    uint8_t* gate;           // 1=on, 0=off
+
+    static uint32_t bytes( int numVoices )
+    {
+        return numVoices * ( sizeof(four::FeedbackHistory) * 4 * 2 + sizeof(float) * 4 * 5
+                             + sizeof(float) * 5
+                             + sizeof(uint32_t) + sizeof(uint8_t) * 2 );
+    }
+
+    void assign( uint8_t* mem, int numVoices )
+    {
+        // Widest fields first keeps every array aligned
+        phase      = (four::Phase (*)[4])mem;  mem += numVoices * sizeof(four::Phase) * 4;
+        prevOutput = (four::FeedbackHistory (*)[4])mem;
+        mem += numVoices * sizeof(four::FeedbackHistory) * 4;
+        inc        = (float (*)[4])mem;  mem += numVoices * sizeof(float) * 4;
+        foldHistory = (float (*)[4])mem; mem += numVoices * sizeof(float) * 4;
+        fadePhase  = (four::Phase (*)[4])mem;  mem += numVoices * sizeof(four::Phase) * 4;
+        fadePrevOutput = (four::FeedbackHistory (*)[4])mem;
+        mem += numVoices * sizeof(four::FeedbackHistory) * 4;
+        fadeFoldHistory = (float (*)[4])mem;  mem += numVoices * sizeof(float) * 4;
+        frequency  = (float*)mem;        mem += numVoices * sizeof(float);
+        glideTo    = (float*)mem;        mem += numVoices * sizeof(float);
+        glide      = (float*)mem;        mem += numVoices * sizeof(float);
+        amp        = (float*)mem;        mem += numVoices * sizeof(float);
+        fadeAmp    = (float*)mem;        mem += numVoices * sizeof(float);
+        age        = (uint32_t*)mem;     mem += numVoices * sizeof(uint32_t);
+        note       = mem;                mem += numVoices;
+        gate       = mem;
+
+        for ( int v = 0; v < numVoices; ++v )
+        {
+            for ( int op = 0; op < 4; ++op )
+            {
+                phase[v][op] = 0;
+                prevOutput[v][op].last = prevOutput[v][op].prior = 0.0f;
+                inc[v][op] = 0.0f;
+                foldHistory[v][op] = 0.0f;
+            }
+            frequency[v] = glideTo[v] = 261.63f;  // C4
+            glide[v] = 1.0f;
+            amp[v] = 0.0f;
+            age[v] = 0;
+            note[v] = 60;
+            gate[v] = 0;
+        }
+    }
+};
+
+struct ProgramBank;
+struct SysExReceiver;
+
+// CV inputs with a Rate setting, in parameter order: XM, Global VCA, then
+// Level, PM, Warp and Fold for operators 1-4
+enum {
+    kRatedXM, kRatedVCA,
+    kRatedLevel,
+    kRatedPM   = kRatedLevel + 4,
+    kRatedWarp = kRatedPM + 4,
+    kRatedFold = kRatedWarp + 4,
+    kNumRatedCV = kRatedFold + 4
+};
+
+// An operator's sync source: kSyncOp + k is the k-th operator above it
+enum { kSyncOff, kSyncCV, kSyncOp };
+
+// A note or pitch bend waiting for its frame in the next block
+struct MidiEvent
+{
+    uint16_t frame;          // offset into the block it plays in
+    uint8_t status;
+    uint8_t data1;
+    uint8_t data2;
+};
+
 // --- Algorithm struct ---
 
 struct _fourAlgorithm : public _NT_algorithm
 {
-    // Oscillator state
-    float phase[4];
-    float prevOutput[4];     // Previous output for feedback
-
-    // Cached parameter values (set by parameterChanged)
-    float opLevel[4];        // 0.0-1.0
+    // Voices
+    VoicePool voices;
+    uint8_t numVoices;       // 1 = monophonic
+    uint32_t noteCounter;    // Stamps voice age on note-on
+
+    // Cached parameter values (set by parameterChanged). Smoothed values
+    // hold the target; step() ramps toward it.
+    four::SmoothedValue opLevel[4];     // 0.0-1.0
     float opLevelCVDepth[4]; // 0.0-1.0
     float opPMCVDepth[4];    // 0.0-1.0
     float opWarpCVDepth[4];  // 0.0-1.0
     float opFoldCVDepth[4];  // 0.0-1.0
-    float opFeedback[4];     // 0.0-1.0
-    float opWarp[4];         // 0.0-1.0
-    float opFold[4];         // 0.0-1.0
+    float opFMCVDepth[4];    // 0.0-1.0
+    bool fmThroughZero;      // FM CV may push an operator below 0 Hz
+    uint8_t opSync[4];       // sync source, kSyncOff/CV/Op
+    float syncPrev;          // Sync CV at the end of the last step()
+    uint8_t cvRate[kNumRatedCV];  // audio, control or block rate
+    float cvHeld[kNumRatedCV];    // volts at the last control point
+    four::SmoothedValue opFeedback[4];  // 0.0-1.0
+    float feedbackAverage;   // 0 = last output, 0.5 = DX two-sample mean
+    four::SmoothedValue opWarp[4];      // 0.0-1.0
+    four::SmoothedValue opFold[4];      // 0.0-1.0
     uint8_t opFoldType[4];   // 0-2
+    uint8_t opFoldAA[4];     // 0=off, 1=ADAA
     uint8_t opFreqMode[4];   // 0=ratio, 1=fixed
     float opCoarse[4];       // harmonic ratio (ratio mode)
     float opFixedHz[4];      // Hz (fixed mode)
-    float opFine[4];         // multiplier from cents
-
-    float xm;                // 0.0-1.0
-    float globalVCA;         // 0.0-1.0
-    float fineTune;          // multiplier from cents
+    four::SmoothedValue opFine[4];      // multiplier from cents
+
+    four::SmoothedValue xm;             // 0.0-1.0
+    four::SmoothedValue globalVCA;      // 0.0-1.0
+    four::SmoothedValue fineTune;       // multiplier from cents
+    float smoothTime;        // seconds, 0 = off
+    uint8_t voctMode;        // 0=exact, 1=fast, 2=control rate
+
+    // Frequency cache. Tuning (scale/offset, see calc_operator_tuning)
+    // and per-voice increments are rebuilt at the next block after any
+    // tuning, note, bend or sample rate change.
+    float opScale[4];
+    float opOffset[4];
+    bool incDirty;
+    uint32_t cachedSampleRate;
+    uint8_t cachedRate;      // oversampling factor of the main render path
+    float invEffectiveRate;  // 1 / (sample rate × oversampling)
+    float voctPrev;          // last V/OCT multiplier, for control rate
     uint8_t algorithm;       // 0-10
-    uint8_t oversample;      // 0=off, 1=2x
-    uint8_t polyblep;        // 0=off, 1=on
+    uint8_t oversample;      // 0=off, 1=2x, 2=4x, 3=8x, 4=auto
+    uint8_t maxOversample;   // highest allocated, from the specification
+    uint8_t decimatorQuality; // four::DecimatorQuality
+    uint8_t warpMode;        // four::WarpAntialias
+    const four::WarpTables* warpTables;  // shared, built by initialise()
 
     // MIDI state
-    float baseFrequency;     // Hz, from V/OCT or MIDI
+    float pitchBend;         // -1 to +1, from the wheel
     float pitchBendFactor;   // multiplier (1.0 = no bend)
-    uint8_t midiNote;        // current MIDI note number
-    uint8_t midiGate;        // 1=on, 0=off
+    float bendRange;         // semitones at full bend
+    float glideTime;         // seconds, 0 = off
+    uint8_t glideLegato;     // 1 = glide only between held notes
+    uint8_t lastVoice;       // voice of the latest note on, glided from
     uint8_t midiChannel;     // 0-15
+    four::EventRing<MidiEvent, 32> midiEvents;  // played by the next step()
+    uint32_t stepClock;      // cycleCount() when the last step() began
+    uint32_t stepTicks;      // ticks between the last two step() calls
+    uint16_t stepFrames;     // frames in the last step()
+
+    // CC updates, applied at the start of the next step(). applied[] holds
+    // the last value cached for each CC-mappable parameter (all below 128),
+    // so the host's echo of a queued update is not converted twice.
+    four::ParamQueue<64> updates;
+    int16_t applied[128];
+
+    // Programs, recalled by Program Change
+    ProgramBank* programs;   // in DRAM, after the warp tables
+    uint8_t program;         // 0-127, last recalled or selected
+    SysExReceiver* sysex;    // voice dump parser, in DRAM after the bank
 
     // Oversampling state
-    float dsBuffer[2];       // Downsample filter state
+    four::DecimatorChain decimators[2];  // active and crossfade-out
+    uint8_t activeChain;
+    uint8_t fadeRate;        // factor being crossfaded out, 0 = none
+    int fadeFrames;          // frames left in the crossfade
+    int autoHold;            // frames before Auto may lower the factor
+    float fadeOut[four::BLOCK_SIZE];
     four::DCBlocker dcBlocker;                // DC blocker
 
+    // Silence skipping: blocks that provably output nothing skip the
+    // operators; once the filters have rung out, the output stage too
+    bool idle;               // decimators and DC blocker are at rest
+    uint32_t skippedBlocks;  // total, since construction
+    uint32_t windowBlocks;   // this CPU meter window
+    uint32_t windowSkipped;
+    float idlePercent;       // skipped share of the last window
+
+    // CPU meters, in counter ticks per output sample
+    four::CpuMeter cpu[kNumCpuStages];
+    uint32_t cpuTicks[kNumCpuStages];  // this step
+    uint32_t cpuWindowFrames;
+
+    // Block render scratch
+    four::BlockScratch scratch;
+
     _fourAlgorithm()
     {
-        memset( phase, 0, sizeof(phase) );
-        memset( prevOutput, 0, sizeof(prevOutput) );
+        numVoices = 1;
+        noteCounter = 0;
         for ( int i = 0; i < 4; ++i )
         {
-            opLevel[i] = 1.0f;
+            opLevel[i].reset( 1.0f );
             opLevelCVDepth[i] = 0.0f;
             opPMCVDepth[i] = 0.0f;
             opWarpCVDepth[i] = 0.0f;
             opFoldCVDepth[i] = 0.0f;
-            opFeedback[i] = 0.0f;
-            opWarp[i] = 0.0f;
-            opFold[i] = 0.0f;
+            opFMCVDepth[i] = 1.0f;
+            opSync[i] = kSyncCV;
+            opFeedback[i].reset( 0.0f );
+            opWarp[i].reset( 0.0f );
+            opFold[i].reset( 0.0f );
             opFoldType[i] = 0;
+            opFoldAA[i] = 0;
             opFreqMode[i] = 0;
             opCoarse[i] = 1.0f;
             opFixedHz[i] = 440.0f;
-            opFine[i] = 1.0f;
+            opFine[i].reset( 1.0f );
+            opFine[i].onePole = true;
+        }
+        xm.reset( 0.0f );
+        globalVCA.reset( 1.0f );
+        fineTune.reset( 1.0f );
+        fineTune.onePole = true;
+        smoothTime = 0.01f;
+        voctMode = 0;
+        fmThroughZero = false;
+        feedbackAverage = 0.0f;
+        syncPrev = 0.0f;
+        for ( int i = 0; i < kNumRatedCV; ++i )
+        {
+            cvRate[i] = 0;
+            cvHeld[i] = 0.0f;
+        }
+        for ( int i = 0; i < 4; ++i )
+        {
+            opScale[i] = 0.0f;
+            opOffset[i] = 0.0f;
         }
-        xm = 0.0f;
-        globalVCA = 1.0f;
-        fineTune = 1.0f;
+        incDirty = true;
+        cachedSampleRate = 0;
+        cachedRate = 0;
+        invEffectiveRate = 0.0f;
+        voctPrev = 1.0f;
         algorithm = 0;
         oversample = 1;            // Default ON
-        polyblep = 1;             // Default ON
-        baseFrequency = 261.63f;  // C4
+        maxOversample = 1;
+        activeChain = 0;
+        fadeRate = 0;
+        fadeFrames = 0;
+        autoHold = 0;
+        decimatorQuality = four::DECIMATE_IIR;
+        warpMode = four::WARP_POLYBLEP;
+        warpTables = NULL;
+        pitchBend = 0.0f;
         pitchBendFactor = 1.0f;
-        midiNote = 60;
-        midiGate = 0;
+        bendRange = 2.0f;
+        glideTime = 0.0f;
+        glideLegato = 0;
+        lastVoice = 0;
         midiChannel = 0;
-        dsBuffer[0] = 0.0f;
-        dsBuffer[1] = 0.0f;
+        stepClock = 0;
+        stepTicks = 0;
+        stepFrames = 0;
+        programs = NULL;
+        program = 0;
+        sysex = NULL;
+        cpuWindowFrames = 0;
+        idle = false;
+        skippedBlocks = 0;
+        windowBlocks = 0;
+        windowSkipped = 0;
+        idlePercent = 0.0f;
     }
 };
 
@@ -93,7 +340,7 @@ enum {
     kParamXM,
     kParamFineTune,
     kParamOversampling,
-    kParamPolyBLEP,
+    kParamAntiAlias,
     kParamMidiChannel,
     kParamGlobalVCA,
     kParamVersion,
@@ -189,6 +436,51 @@ enum {
     kParamOp3FoldCV,
     kParamOp4FoldCV,
 
+    // Added after 1.1; appended to keep existing preset indices
+    kParamSmoothing,
+    kParamVOctMode,
+    kParamDecimator,
+    kParamCpuMin,
+    kParamCpuAvg,
+    kParamCpuMax,
+    kParamOp1FoldAA,
+    kParamOp2FoldAA,
+    kParamOp3FoldAA,
+    kParamOp4FoldAA,
+    kParamProgram,
+    kParamProgramAction,
+    kParamBendRange,
+    kParamGlide,
+    kParamGlideMode,
+    kParamXMCVRate,
+    kParamGlobalVCACVRate,
+    kParamOp1LevelCVRate,
+    kParamOp2LevelCVRate,
+    kParamOp3LevelCVRate,
+    kParamOp4LevelCVRate,
+    kParamOp1PMCVRate,
+    kParamOp2PMCVRate,
+    kParamOp3PMCVRate,
+    kParamOp4PMCVRate,
+    kParamOp1WarpCVRate,
+    kParamOp2WarpCVRate,
+    kParamOp3WarpCVRate,
+    kParamOp4WarpCVRate,
+    kParamOp1FoldCVRate,
+    kParamOp2FoldCVRate,
+    kParamOp3FoldCVRate,
+    kParamOp4FoldCVRate,
+    kParamFMMode,
+    kParamOp1FMCVDepth,
+    kParamOp2FMCVDepth,
+    kParamOp3FMCVDepth,
+    kParamOp4FMCVDepth,
+    kParamOp1Sync,
+    kParamOp2Sync,
+    kParamOp3Sync,
+    kParamOp4Sync,
+    kParamFeedbackMode,
+
     kNumParams
 };
 
@@ -238,10 +530,27 @@ static const char* ratioStrings[] = {
     "26", "26.5", "27", "27.5", "28", "28.5", "29", "29.5", "30", "30.5", "31", "31.5", "32",
     NULL
 };
-static const char* offOnStrings[]     = { "Off","On", NULL };
-static const char* off2xStrings[]     = { "Off","2x", NULL };
+static const char* antiAliasStrings[] = { "Off","PolyBLEP","Wavetable", NULL };
+static const char* oversampleStrings[] = { "Off","2x","4x","8x","Auto", NULL };
+enum { kOversampleAuto = 4 };
 static const char* freqModeStrings[]  = { "Ratio","Fixed", NULL };
 static const char* foldTypeStrings[]  = { "Symmetric","Asymmetric","Soft Clip", NULL };
+static const char* voctModeStrings[]  = { "Exact","Fast","Control", NULL };
+static const char* decimatorStrings[] = { "IIR","FIR", NULL };
+static const char* foldAAStrings[]    = { "Off","ADAA", NULL };
+static const char* programActionStrings[] = { "-","Recall","Store", NULL };
+static const char* glideModeStrings[] = { "Always","Legato", NULL };
+static const char* cvRateStrings[] = { "Audio","Control","Block", NULL };
+enum { kCVRateAudio, kCVRateControl, kCVRateBlock };
+static const char* fmModeStrings[] = { "Clamped","Through-Zero", NULL };
+static const char* feedbackModeStrings[] = { "Last Sample","DX Average", NULL };
+// Sync source per operator. Only a higher-numbered operator can drive it,
+// as with modulation, so sources render first.
+static const char* op1SyncStrings[] = { "Off","Sync CV","Op2","Op3","Op4", NULL };
+static const char* op2SyncStrings[] = { "Off","Sync CV","Op3","Op4", NULL };
+static const char* op3SyncStrings[] = { "Off","Sync CV","Op4", NULL };
+static const char* op4SyncStrings[] = { "Off","Sync CV", NULL };
+enum { kProgramActionNone, kProgramActionRecall, kProgramActionStore };
 
 static const char* versionStrings[] = { FOUR_VERSION, NULL };
 
@@ -267,8 +576,8 @@ static _NT_parameter parameters[] = {
     { "Algorithm",    0,   10,   0,   kNT_unitEnum,    0, algorithmStrings },
     { "XM",           0,  100,   0,   kNT_unitPercent, 0, NULL },
     { "Fine Tune",  -100, 100,   0,   kNT_unitCents,   0, NULL },
-    { "Oversampling",    0,    1,   1,   kNT_unitEnum,    0, off2xStrings },
-    { "PolyBLEP",       0,    1,   1,   kNT_unitEnum,    0, offOnStrings },
+    { "Oversampling",    0,    4,   1,   kNT_unitEnum,    0, oversampleStrings },
+    { "Anti-alias",     0,    2,   1,   kNT_unitEnum,    0, antiAliasStrings },
     { "MIDI Channel",   1,   16,   1,   kNT_unitNone,    0, NULL },
     { "Global VCA",   0,  100, 100,   kNT_unitPercent, 0, NULL },
 
@@ -327,6 +636,67 @@ static _NT_parameter parameters[] = {
     NT_PARAMETER_CV_INPUT( "Op2 Fold CV",    0, 0 )
     NT_PARAMETER_CV_INPUT( "Op3 Fold CV",    0, 0 )
     NT_PARAMETER_CV_INPUT( "Op4 Fold CV",    0, 0 )
+
+    { "Smoothing",    0,  100,  10,   kNT_unitMs,      0, NULL },
+    { "V/OCT Mode",   0,    2,   0,   kNT_unitEnum,    0, voctModeStrings },
+    { "Decimator",    0,    1,   0,   kNT_unitEnum,    0, decimatorStrings },
+
+    // CPU meters (read-only): cycles per sample over the last window,
+    // written by step(); edits are overwritten
+    { "CPU Min",      0, 32767,  0,   kNT_unitNone,    0, NULL },
+    { "CPU Avg",      0, 32767,  0,   kNT_unitNone,    0, NULL },
+    { "CPU Max",      0, 32767,  0,   kNT_unitNone,    0, NULL },
+
+    { "Op1 Fold AA",  0,    1,   0,   kNT_unitEnum,    0, foldAAStrings },
+    { "Op2 Fold AA",  0,    1,   0,   kNT_unitEnum,    0, foldAAStrings },
+    { "Op3 Fold AA",  0,    1,   0,   kNT_unitEnum,    0, foldAAStrings },
+    { "Op4 Fold AA",  0,    1,   0,   kNT_unitEnum,    0, foldAAStrings },
+
+    // Program slot for Recall/Store; the action returns to "-" once done
+    { "Program",      1,  128,   1,   kNT_unitNone,    0, NULL },
+    { "Program Action", 0,  2,   0,   kNT_unitEnum,    0, programActionStrings },
+
+    { "Bend Range",   0,   24,   2,   kNT_unitSemitones, 0, NULL },
+    { "Glide",        0, 2000,   0,   kNT_unitMs,      0, NULL },
+    { "Glide Mode",   0,    1,   0,   kNT_unitEnum,    0, glideModeStrings },
+
+    // How often each CV input is read (see kRated*): every sample, every
+    // kControlFrames (32) output frames, or once per step()
+    { "XM CV Rate",         0, 2, 0, kNT_unitEnum, 0, cvRateStrings },
+    { "Global VCA CV Rate", 0, 2, 0, kNT_unitEnum, 0, cvRateStrings },
+    { "Op1 Level CV Rate",  0, 2, 0, kNT_unitEnum, 0, cvRateStrings },
+    { "Op2 Level CV Rate",  0, 2, 0, kNT_unitEnum, 0, cvRateStrings },
+    { "Op3 Level CV Rate",  0, 2, 0, kNT_unitEnum, 0, cvRateStrings },
+    { "Op4 Level CV Rate",  0, 2, 0, kNT_unitEnum, 0, cvRateStrings },
+    { "Op1 PM CV Rate",     0, 2, 0, kNT_unitEnum, 0, cvRateStrings },
+    { "Op2 PM CV Rate",     0, 2, 0, kNT_unitEnum, 0, cvRateStrings },
+    { "Op3 PM CV Rate",     0, 2, 0, kNT_unitEnum, 0, cvRateStrings },
+    { "Op4 PM CV Rate",     0, 2, 0, kNT_unitEnum, 0, cvRateStrings },
+    { "Op1 Warp CV Rate",   0, 2, 0, kNT_unitEnum, 0, cvRateStrings },
+    { "Op2 Warp CV Rate",   0, 2, 0, kNT_unitEnum, 0, cvRateStrings },
+    { "Op3 Warp CV Rate",   0, 2, 0, kNT_unitEnum, 0, cvRateStrings },
+    { "Op4 Warp CV Rate",   0, 2, 0, kNT_unitEnum, 0, cvRateStrings },
+    { "Op1 Fold CV Rate",   0, 2, 0, kNT_unitEnum, 0, cvRateStrings },
+    { "Op2 Fold CV Rate",   0, 2, 0, kNT_unitEnum, 0, cvRateStrings },
+    { "Op3 Fold CV Rate",   0, 2, 0, kNT_unitEnum, 0, cvRateStrings },
+    { "Op4 Fold CV Rate",   0, 2, 0, kNT_unitEnum, 0, cvRateStrings },
+
+    // Clamped stops an operator at 0 Hz; Through-Zero runs it backwards
+    { "FM Mode",      0,    1,   0,   kNT_unitEnum,    0, fmModeStrings },
+    { "Op1 FM CV Depth", 0, 100, 100, kNT_unitPercent, 0, NULL },
+    { "Op2 FM CV Depth", 0, 100, 100, kNT_unitPercent, 0, NULL },
+    { "Op3 FM CV Depth", 0, 100, 100, kNT_unitPercent, 0, NULL },
+    { "Op4 FM CV Depth", 0, 100, 100, kNT_unitPercent, 0, NULL },
+
+    { "Op1 Sync",     0,    4,   1,   kNT_unitEnum,    0, op1SyncStrings },
+    { "Op2 Sync",     0,    3,   1,   kNT_unitEnum,    0, op2SyncStrings },
+    { "Op3 Sync",     0,    2,   1,   kNT_unitEnum,    0, op3SyncStrings },
+    { "Op4 Sync",     0,    1,   1,   kNT_unitEnum,    0, op4SyncStrings },
+
+    // DX Average feeds back the mean of the last two outputs, which stays
+    // clean at high amounts and at every oversampling factor. Defaults to
+    // Last Sample so existing presets keep their sound
+    { "Feedback Mode", 0,   1,   0,   kNT_unitEnum,    0, feedbackModeStrings },
 };
 
 // --- Parameter pages ---
@@ -334,28 +704,35 @@ static _NT_parameter parameters[] = {
 static const uint8_t pageIO[] = { kParamOutput, kParamOutputMode };
 static const uint8_t pageGlobal[] = {
     kParamAlgorithm, kParamXM, kParamFineTune,
-    kParamOversampling, kParamPolyBLEP,
-    kParamGlobalVCA, kParamVersion
+    kParamOversampling, kParamDecimator, kParamAntiAlias,
+    kParamGlobalVCA, kParamSmoothing, kParamFeedbackMode, kParamVersion
 };
-static const uint8_t pageMIDI[] = { kParamMidiChannel };
+static const uint8_t pageMIDI[] = {
+    kParamMidiChannel, kParamBendRange, kParamGlide, kParamGlideMode,
+    kParamProgram, kParamProgramAction
+};
+static const uint8_t pageCPU[] = { kParamCpuMin, kParamCpuAvg, kParamCpuMax };
 
 #define OP_PAGE(n) \
     static const uint8_t pageOp##n[] = { \
         kParamOp##n##FreqMode, kParamOp##n##Coarse, kParamOp##n##FixedHz, \
         kParamOp##n##Fine, kParamOp##n##Level, kParamOp##n##Feedback, \
-        kParamOp##n##Warp, kParamOp##n##Fold, kParamOp##n##FoldType \
+        kParamOp##n##Warp, kParamOp##n##Fold, kParamOp##n##FoldType, \
+        kParamOp##n##FoldAA, kParamOp##n##Sync \
     };
 OP_PAGE(1) OP_PAGE(2) OP_PAGE(3) OP_PAGE(4)
 
 static const uint8_t pageCVGlobal[] = {
-    kParamVOctCV, kParamXMCV, kParamFMCV, kParamSyncCV, kParamGlobalVCACV
+    kParamVOctCV, kParamVOctMode, kParamXMCV, kParamXMCVRate, kParamFMCV, kParamFMMode, kParamSyncCV,
+    kParamGlobalVCACV, kParamGlobalVCACVRate
 };
 #define CV_PAGE(n) \
     static const uint8_t pageCVOp##n[] = { \
-        kParamOp##n##LevelCV, kParamOp##n##LevelCVDepth, \
-        kParamOp##n##PMCV, kParamOp##n##PMCVDepth, \
-        kParamOp##n##WarpCV, kParamOp##n##WarpCVDepth, \
-        kParamOp##n##FoldCV, kParamOp##n##FoldCVDepth \
+        kParamOp##n##LevelCV, kParamOp##n##LevelCVDepth, kParamOp##n##LevelCVRate, \
+        kParamOp##n##PMCV, kParamOp##n##PMCVDepth, kParamOp##n##PMCVRate, \
+        kParamOp##n##WarpCV, kParamOp##n##WarpCVDepth, kParamOp##n##WarpCVRate, \
+        kParamOp##n##FoldCV, kParamOp##n##FoldCVDepth, kParamOp##n##FoldCVRate, \
+        kParamOp##n##FMCVDepth \
     };
 CV_PAGE(1) CV_PAGE(2) CV_PAGE(3) CV_PAGE(4)
 
@@ -372,6 +749,7 @@ static const _NT_parameterPage pages[] = {
     { .name = "CV Op2",     .numParams = ARRAY_SIZE(pageCVOp2),     .params = pageCVOp2 },
     { .name = "CV Op3",     .numParams = ARRAY_SIZE(pageCVOp3),     .params = pageCVOp3 },
     { .name = "CV Op4",     .numParams = ARRAY_SIZE(pageCVOp4),     .params = pageCVOp4 },
+    { .name = "CPU",        .numParams = ARRAY_SIZE(pageCPU),       .params = pageCPU },
 };
 
 static const _NT_parameterPages parameterPages = {
@@ -381,12 +759,13 @@ static const _NT_parameterPages parameterPages = {
 
 // --- MIDI CC mapping ---
 
-// CC 14-72 → 59 value parameters (excludes CV bus selectors)
-// 7 global + 36 per-op (9×4) + 16 CV depths (4×4)
+// CC 14-79 → 66 value parameters (excludes CV bus selectors)
+// 7 global + 36 per-op (9×4) + 16 CV depths (4×4) + smoothing, V/OCT mode,
+// decimator + fold AA (4); CC 80-91 → bend, glide, FM and sync settings
 static const int8_t ccToParam[128] = {
     -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,                     // 0-13
     kParamAlgorithm, kParamXM, kParamFineTune,                      // 14-16
-    kParamOversampling, kParamPolyBLEP, kParamMidiChannel,          // 17-19
+    kParamOversampling, kParamAntiAlias, kParamMidiChannel,          // 17-19
     kParamGlobalVCA,                                                // 20
     kParamOp1FreqMode, kParamOp1Coarse, kParamOp1FixedHz,          // 21-23
     kParamOp1Fine, kParamOp1Level, kParamOp1Feedback,               // 24-26
@@ -408,8 +787,16 @@ static const int8_t ccToParam[128] = {
     kParamOp3WarpCVDepth, kParamOp4WarpCVDepth,                    // 67-68
     kParamOp1FoldCVDepth, kParamOp2FoldCVDepth,                    // 69-70
     kParamOp3FoldCVDepth, kParamOp4FoldCVDepth,                    // 71-72
-    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,               // 73-88
-    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,               // 89-104
+    kParamSmoothing, kParamVOctMode, kParamDecimator,              // 73-75
+    kParamOp1FoldAA, kParamOp2FoldAA,                              // 76-77
+    kParamOp3FoldAA, kParamOp4FoldAA,                              // 78-79
+    kParamBendRange, kParamGlide, kParamGlideMode,                 // 80-82
+    kParamOp1FMCVDepth, kParamOp2FMCVDepth,                        // 83-84
+    kParamOp3FMCVDepth, kParamOp4FMCVDepth,                        // 85-86
+    kParamFMMode,                                                  // 87
+    kParamOp1Sync, kParamOp2Sync, kParamOp3Sync, kParamOp4Sync,    // 88-91
+    kParamFeedbackMode,                                            // 92
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,                           // 93-104
     -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,               // 105-120
     -1,-1,-1,-1,-1,-1,-1                                           // 121-127
 };
@@ -422,15 +809,292 @@ static int16_t scaleCCToParam( uint8_t ccValue, int paramIndex )
     return mn + (int16_t)( (int32_t)ccValue * ( mx - mn ) / 127 );
 }
 
+// --- Programs ---
+
+// The sound parameters a program holds, in record order. Instance settings
+// (I/O, CV buses, MIDI, oversampling, smoothing, Global VCA) stay put.
+// Append only: stored records keep their length, and parameters added
+// since take their defaults on recall.
+static const uint8_t programParams[] = {
+    kParamAlgorithm, kParamXM, kParamFineTune, kParamAntiAlias,
+    kParamOp1FreqMode, kParamOp1Coarse, kParamOp1FixedHz, kParamOp1Fine, kParamOp1Level,
+    kParamOp1Feedback, kParamOp1Warp, kParamOp1Fold, kParamOp1FoldType,
+    kParamOp2FreqMode, kParamOp2Coarse, kParamOp2FixedHz, kParamOp2Fine, kParamOp2Level,
+    kParamOp2Feedback, kParamOp2Warp, kParamOp2Fold, kParamOp2FoldType,
+    kParamOp3FreqMode, kParamOp3Coarse, kParamOp3FixedHz, kParamOp3Fine, kParamOp3Level,
+    kParamOp3Feedback, kParamOp3Warp, kParamOp3Fold, kParamOp3FoldType,
+    kParamOp4FreqMode, kParamOp4Coarse, kParamOp4FixedHz, kParamOp4Fine, kParamOp4Level,
+    kParamOp4Feedback, kParamOp4Warp, kParamOp4Fold, kParamOp4FoldType,
+    kParamOp1LevelCVDepth, kParamOp2LevelCVDepth, kParamOp3LevelCVDepth, kParamOp4LevelCVDepth,
+    kParamOp1PMCVDepth, kParamOp2PMCVDepth, kParamOp3PMCVDepth, kParamOp4PMCVDepth,
+    kParamOp1WarpCVDepth, kParamOp2WarpCVDepth, kParamOp3WarpCVDepth, kParamOp4WarpCVDepth,
+    kParamOp1FoldCVDepth, kParamOp2FoldCVDepth, kParamOp3FoldCVDepth, kParamOp4FoldCVDepth,
+    kParamOp1FoldAA, kParamOp2FoldAA, kParamOp3FoldAA, kParamOp4FoldAA,
+    kParamBendRange, kParamGlide, kParamGlideMode,
+    kParamOp1FMCVDepth, kParamOp2FMCVDepth, kParamOp3FMCVDepth, kParamOp4FMCVDepth,
+    kParamOp1Sync, kParamOp2Sync, kParamOp3Sync, kParamOp4Sync,
+    kParamFeedbackMode,
+};
+enum { kNumProgramParams = ARRAY_SIZE(programParams), kNumPrograms = 128 };
+
+struct Program
+{
+    int16_t value[kNumProgramParams];  // raw parameter values
+    uint8_t count;           // values stored, 0 = empty slot
+};
+
+// Changes from the defaults, one run per factory program, each ended by
+// kNumParams. The rest of the bank starts empty.
+struct ProgramValue
+{
+    uint8_t param;
+    int16_t value;
+};
+
+static const ProgramValue factoryPrograms[] = {
+    // 1 Init
+    { kNumParams, 0 },
+    // 2 Tine piano: two stacks, a 14:1 tine over 1:1
+    { kParamAlgorithm, 4 }, { kParamXM, 45 },
+    { kParamOp2Coarse, 29 }, { kParamOp2Level, 30 },
+    { kParamOp3Level, 70 }, { kParamOp4Level, 55 },
+    { kNumParams, 0 },
+    // 3 Bell: 3.5:1 and 7:1 modulators
+    { kParamAlgorithm, 2 }, { kParamXM, 55 },
+    { kParamOp2Coarse, 8 }, { kParamOp3Coarse, 4 }, { kParamOp3Level, 50 },
+    { kParamOp4Coarse, 15 }, { kParamOp4Level, 40 },
+    { kNumParams, 0 },
+    // 4 Bass: sub carrier under a chain with feedback at the top
+    { kParamXM, 50 }, { kParamOp1Coarse, 1 },
+    { kParamOp2Level, 80 }, { kParamOp3Coarse, 5 }, { kParamOp3Level, 40 },
+    { kParamOp4Level, 30 }, { kParamOp4Feedback, 35 },
+    { kNumParams, 0 },
+    // 5 Organ: additive footages
+    { kParamAlgorithm, 7 },
+    { kParamOp1Coarse, 1 }, { kParamOp1Level, 90 },
+    { kParamOp3Coarse, 5 }, { kParamOp3Level, 70 },
+    { kParamOp4Coarse, 9 }, { kParamOp4Level, 45 },
+    { kNumParams, 0 },
+    // 6 Metal: 1.5, 3.5 and 5.5:1 modulators into a folded carrier
+    { kParamAlgorithm, 1 }, { kParamXM, 70 },
+    { kParamOp1Fold, 40 }, { kParamOp2Coarse, 4 }, { kParamOp3Coarse, 8 },
+    { kParamOp4Coarse, 12 }, { kParamOp4Feedback, 50 },
+    { kNumParams, 0 },
+    // 7 Fold lead: warped, folded carrier with ADAA
+    { kParamXM, 25 },
+    { kParamOp1Warp, 35 }, { kParamOp1Fold, 55 }, { kParamOp1FoldAA, 1 },
+    { kParamOp2Coarse, 5 }, { kParamOp2Level, 40 },
+    { kNumParams, 0 },
+    // 8 Pad: three detuned carriers under one modulator
+    { kParamAlgorithm, 5 }, { kParamXM, 20 },
+    { kParamOp1Fine, -7 }, { kParamOp2Fine, 7 },
+    { kParamOp3Coarse, 5 }, { kParamOp3Level, 50 }, { kParamOp3FoldType, 2 },
+    { kParamOp4Level, 30 },
+    { kNumParams, 0 },
+};
+
+struct ProgramBank
+{
+    Program slot[kNumPrograms];
+
+    void clear()
+    {
+        for ( int i = 0; i < kNumPrograms; ++i )
+            slot[i].count = 0;
+    }
+
+    void loadFactory()
+    {
+        clear();
+        int n = 0;
+        Program* prog = NULL;
+        for ( unsigned int i = 0; i < ARRAY_SIZE(factoryPrograms); ++i )
+        {
+            const ProgramValue& pv = factoryPrograms[i];
+            if ( !prog )
+            {
+                prog = &slot[n++];
+                for ( int j = 0; j < kNumProgramParams; ++j )
+                    prog->value[j] = parameters[programParams[j]].def;
+                prog->count = kNumProgramParams;
+            }
+            if ( pv.param == kNumParams )
+            {
+                prog = NULL;
+                continue;
+            }
+            for ( int j = 0; j < kNumProgramParams; ++j )
+            {
+                if ( programParams[j] == pv.param )
+                    prog->value[j] = pv.value;
+            }
+        }
+    }
+};
+
+// Presets carry the bank as one record per stored slot: the values as
+// 16-bit two's complement, big-endian, hex encoded
+static const int kProgramRecordChars = kNumProgramParams * 4;
+
+static void encodeProgram( const Program& prog, char* out )
+{
+    static const char digits[] = "0123456789abcdef";
+    for ( int i = 0; i < prog.count; ++i )
+    {
+        uint16_t v = (uint16_t)prog.value[i];
+        for ( int d = 3; d >= 0; --d )
+            *out++ = digits[( v >> ( d * 4 ) ) & 0xF];
+    }
+    *out = 0;
+}
+
+static int hexDigit( char c )
+{
+    if ( c >= '0' && c <= '9' ) return c - '0';
+    if ( c >= 'a' && c <= 'f' ) return c - 'a' + 10;
+    if ( c >= 'A' && c <= 'F' ) return c - 'A' + 10;
+    return -1;
+}
+
+// Values beyond what this version stores are ignored; out-of-range ones
+// are clamped. Returns false on malformed data.
+static bool decodeProgram( const char* hex, Program& prog )
+{
+    int n = 0;
+    for ( ; hex[n * 4]; ++n )
+    {
+        uint16_t v = 0;
+        for ( int d = 0; d < 4; ++d )
+        {
+            int x = hexDigit( hex[n * 4 + d] );
+            if ( x < 0 )
+                return false;
+            v = ( v << 4 ) | x;
+        }
+        if ( n < kNumProgramParams )
+        {
+            const _NT_parameter& def = parameters[programParams[n]];
+            int16_t value = (int16_t)v;
+            prog.value[n] = value < def.min ? def.min : value > def.max ? def.max : value;
+        }
+    }
+    prog.count = n < kNumProgramParams ? n : kNumProgramParams;
+    return true;
+}
+
+// --- SysEx voice import state ---
+
+// Yamaha 4-op bulk dumps (TX81Z, DX21/27/100, DX11): F0 43 0n <format>
+// <count MSB> <count LSB> <data> <checksum> F7
+enum {
+    kSysExVCED = 0x03,       // one voice, 93 bytes
+    kSysExVMEM = 0x04,       // 32 voices × 128 bytes
+    kSysExACED = 0x7E,       // TX81Z additional voice data, sent before VCED
+};
+enum { kVCEDBytes = 93, kVMEMVoiceBytes = 128, kVMEMVoices = 32, kACEDBytes = 33 };
+
+enum { kSysExIdle, kSysExHeader, kSysExData, kSysExChecksum, kSysExSkip };
+
+struct YamahaOperator
+{
+    uint8_t out;             // output level 0-99
+    uint8_t crs;             // ratio index, or fixed frequency coarse
+    uint8_t det;             // detune 0-6, 3 = none
+    uint8_t fixed;           // TX81Z fixed frequency mode
+    uint8_t fixRange;        // 0-7
+    uint8_t fine;            // 0-15
+};
+
+struct YamahaVoice
+{
+    YamahaOperator op[4];    // by operator number, 1-4
+    uint8_t alg;             // 0-7
+    uint8_t fbl;             // feedback on operator 4, 0-7
+    uint8_t pbr;             // pitch bend range, semitones 0-12
+};
+
+// A received voice waiting for step(): the current sound (slot -1), or a
+// bank slot
+struct ImportedVoice
+{
+    YamahaVoice voice;
+    int16_t slot;
+};
+
+// Parsed a byte at a time across midiSysEx() calls. Each voice's record is
+// unpacked as soon as its bytes are in and staged until the checksum
+// passes, so a bad dump changes nothing. Translating onto Four's
+// parameters is the costly part: step() does it, one voice per block, so
+// even a whole bank delivered in one call stays off the audio deadline.
+struct SysExReceiver
+{
+    uint8_t state;
+    uint8_t format;
+    uint8_t sum;
+    uint8_t headerLength;
+    uint8_t header[5];       // 43 0n format count count
+    uint16_t expected;       // data bytes
+    uint16_t received;
+    uint8_t record[kVMEMVoiceBytes];  // voice being received
+    uint8_t aced[4][5];      // FIX, FIXRG, FINE, OSW, SHFT per VCED op block
+    bool acedValid;
+    uint8_t numStaged;
+    YamahaVoice staged[kVMEMVoices];
+    four::EventRing<ImportedVoice, 2 * kVMEMVoices> imported;  // translated by step()
+
+    SysExReceiver() : state( kSysExIdle ), acedValid( false ), numStaged( 0 ) {}
+};
+
+// --- Specifications ---
+
+enum {
+    kSpecVoices,
+    kSpecMaxOversampling,
+};
+
+static const _NT_specification specifications[] = {
+    { .name = "Voices", .min = 1, .max = 8, .def = 1, .type = kNT_typeGeneric },
+    // 1=2x, 2=4x, 3=8x; the Oversampling parameter is capped to this
+    { .name = "Max Oversampling", .min = 1, .max = 3, .def = 1, .type = kNT_typeGeneric },
+};
+
+// Decimation stages above 2x live between the algorithm struct and the
+// voice pool, and are only allocated when the specification allows them.
+// Each of the two chains gets its own.
+static uint32_t decimatorBytes( int maxOversample )
+{
+    return 2 * ( ( maxOversample >= 2 ? sizeof( four::Decimator4x ) : 0 )
+               + ( maxOversample >= 3 ? sizeof( four::Decimator8x ) : 0 ) );
+}
+
 // --- Lifecycle ---
 
+// The band-limited warp tables are the same for every instance, so one
+// copy lives in the factory's static DRAM
+static const four::WarpTables* sharedWarpTables = NULL;
+
+static void calculateStaticRequirements( _NT_staticRequirements& req )
+{
+    req.dram = sizeof( four::WarpTables );
+}
+
+static void initialise( _NT_staticMemoryPtrs& ptrs, const _NT_staticRequirements& req )
+{
+    four::WarpTables* tables = new ( ptrs.dram ) four::WarpTables;
+    tables->build();
+    sharedWarpTables = tables;
+}
+
 static void calculateRequirements(
     _NT_algorithmRequirements& req,
     const int32_t* specifications )
 {
+    int numVoices = specifications[kSpecVoices];
     req.numParameters = ARRAY_SIZE(parameters);
-    req.sram = sizeof( _fourAlgorithm );
-    req.dram = 0;
+    req.sram = sizeof( _fourAlgorithm )
+             + decimatorBytes( specifications[kSpecMaxOversampling] )
+             + VoicePool::bytes( numVoices );
+    req.dram = sizeof( ProgramBank ) + sizeof( SysExReceiver );
     req.dtc = 0;
     req.itc = 0;
 }
@@ -440,7 +1104,36 @@ static _NT_algorithm* construct(
     const _NT_algorithmRequirements& req,
     const int32_t* specifications )
 {
+    four::init_sine_table();
+    enableCycleCounter();
+
     _fourAlgorithm* alg = new ( ptrs.sram ) _fourAlgorithm();
+    alg->numVoices = specifications[kSpecVoices];
+    alg->maxOversample = specifications[kSpecMaxOversampling];
+    for ( int i = 0; i < 128; ++i )
+        alg->applied[i] = INT16_MIN;  // nothing cached yet
+
+    uint8_t* mem = ptrs.sram + sizeof( _fourAlgorithm );
+    for ( int c = 0; c < 2; ++c )
+    {
+        four::DecimatorChain& chain = alg->decimators[c];
+        if ( alg->maxOversample >= 2 )
+        {
+            chain.s4 = new ( mem ) four::Decimator4x();
+            mem += sizeof( four::Decimator4x );
+        }
+        if ( alg->maxOversample >= 3 )
+        {
+            chain.s8 = new ( mem ) four::Decimator8x();
+            mem += sizeof( four::Decimator8x );
+        }
+    }
+    alg->voices.assign( mem, alg->numVoices );
+
+    alg->warpTables = sharedWarpTables;
+    alg->programs = new ( ptrs.dram ) ProgramBank;
+    alg->programs->loadFactory();
+    alg->sysex = new ( ptrs.dram + sizeof( ProgramBank ) ) SysExReceiver;
     alg->parameters = parameters;
     alg->parameterPages = &parameterPages;
     return alg;
@@ -448,9 +1141,20 @@ static _NT_algorithm* construct(
 
 // --- Parameter changed ---
 
-static void parameterChanged( _NT_algorithm* self, int parameter )
+// Coarse enum index to frequency ratio: 0.25, 0.5, 0.75, then 1-32 in 0.5 steps
+static float coarseRatio( int idx )
 {
-    _fourAlgorithm* p = (_fourAlgorithm*)self;
+    if ( idx < 3 )
+        return 0.25f * ( idx + 1 );
+    return (float)( idx - 1 ) * 0.5f;
+}
+
+// Cache one parameter's value. Tuning changes only mark the increments
+// dirty, so any number of changes costs one rebuild at the next block.
+static void applyParameter( _fourAlgorithm* p, int parameter, int16_t value )
+{
+    if ( parameter < 128 )
+        p->applied[parameter] = value;
 
     // Per-operator parameters
     for ( int op = 0; op < 4; ++op )
@@ -462,64 +1166,41 @@ static void parameterChanged( _NT_algorithm* self, int parameter )
             switch ( offset )
             {
             case kOpFreqMode:
-            {
-                p->opFreqMode[op] = p->v[parameter];
-                // Update coarse param unit display based on mode
-                int coarseIdx = base + kOpCoarse;
-                if ( p->opFreqMode[op] == 0 ) // Ratio
-                {
-                    parameters[coarseIdx].unit = kNT_unitEnum;
-                }
-                else // Fixed
-                {
-                    parameters[coarseIdx].unit = kNT_unitHz;
-                }
-                NT_updateParameterDefinition(
-                    NT_algorithmIndex(self), coarseIdx );
+                p->opFreqMode[op] = value;
+                p->incDirty = true;
                 break;
-            }
             case kOpCoarse:
-            {
-                // Ratio mode: convert enum index to float ratio
-                if ( p->opFreqMode[op] == 0 ) // Ratio
-                {
-                    int idx = p->v[parameter];
-                    if ( idx == 0 )
-                        p->opCoarse[op] = 0.25f;
-                    else if ( idx == 1 )
-                        p->opCoarse[op] = 0.5f;
-                    else if ( idx == 2 )
-                        p->opCoarse[op] = 0.75f;
-                    else
-                        p->opCoarse[op] = (float)( idx - 1 ) * 0.5f;
-                }
-                // Fixed mode: handled by kOpFixedHz, ignore here
+                // Converted in either mode (Fixed mode uses kOpFixedHz), so
+                // a later switch back to Ratio finds the ratio current
+                p->opCoarse[op] = coarseRatio( value );
+                p->incDirty = true;
                 break;
-            }
             case kOpFixedHz:
             {
                 // Fixed mode: Hz value
-                p->opFixedHz[op] = (float)p->v[parameter];
+                p->opFixedHz[op] = (float)value;
+                p->incDirty = true;
                 break;
             }
             case kOpFine:
                 // Convert cents to ratio multiplier: 2^(cents/1200)
-                p->opFine[op] = exp2f( (float)p->v[parameter] / 1200.0f );
+                p->opFine[op].set( exp2f( (float)value / 1200.0f ), p->smoothTime );
+                p->incDirty = true;
                 break;
             case kOpLevel:
-                p->opLevel[op] = (float)p->v[parameter] * 0.01f;
+                p->opLevel[op].set( (float)value * 0.01f, p->smoothTime );
                 break;
             case kOpFeedback:
-                p->opFeedback[op] = (float)p->v[parameter] * 0.01f;
+                p->opFeedback[op].set( (float)value * 0.01f, p->smoothTime );
                 break;
             case kOpWarp:
-                p->opWarp[op] = (float)p->v[parameter] * 0.01f;
+                p->opWarp[op].set( (float)value * 0.01f, p->smoothTime );
                 break;
             case kOpFold:
-                p->opFold[op] = (float)p->v[parameter] * 0.01f;
+                p->opFold[op].set( (float)value * 0.01f, p->smoothTime );
                 break;
             case kOpFoldType:
-                p->opFoldType[op] = p->v[parameter];
+                p->opFoldType[op] = value;
                 break;
             }
             return;
@@ -530,282 +1211,1227 @@ static void parameterChanged( _NT_algorithm* self, int parameter )
     switch ( parameter )
     {
     case kParamAlgorithm:
-        p->algorithm = p->v[parameter];
+        p->algorithm = value;
         break;
     case kParamXM:
-        p->xm = (float)p->v[parameter] * 0.01f;
+        p->xm.set( (float)value * 0.01f, p->smoothTime );
         break;
     case kParamFineTune:
-        p->fineTune = exp2f( (float)p->v[parameter] / 1200.0f );
+        p->fineTune.set( exp2f( (float)value / 1200.0f ), p->smoothTime );
+        p->incDirty = true;
         break;
     case kParamOversampling:
-        p->oversample = p->v[parameter];
+        p->oversample = value;
         break;
-    case kParamPolyBLEP:
-        p->polyblep = p->v[parameter];
+    case kParamAntiAlias:
+        p->warpMode = value;
         break;
     case kParamMidiChannel:
-        p->midiChannel = p->v[parameter] - 1;  // 1-16 → 0-15
+        p->midiChannel = value - 1;  // 1-16 → 0-15
         break;
     case kParamGlobalVCA:
-        p->globalVCA = (float)p->v[parameter] * 0.01f;
+        p->globalVCA.set( (float)value * 0.01f, p->smoothTime );
+        break;
+    case kParamSmoothing:
+        p->smoothTime = (float)value * 0.001f;
+        break;
+    case kParamVOctMode:
+        p->voctMode = value;
+        break;
+    case kParamDecimator:
+        p->decimatorQuality = value;
+        p->decimators[0].reset();
+        p->decimators[1].reset();
         break;
 
     // Operator Level CV Depth
     case kParamOp1LevelCVDepth:
-        p->opLevelCVDepth[0] = (float)p->v[parameter] * 0.01f;
+        p->opLevelCVDepth[0] = (float)value * 0.01f;
         break;
     case kParamOp2LevelCVDepth:
-        p->opLevelCVDepth[1] = (float)p->v[parameter] * 0.01f;
+        p->opLevelCVDepth[1] = (float)value * 0.01f;
         break;
     case kParamOp3LevelCVDepth:
-        p->opLevelCVDepth[2] = (float)p->v[parameter] * 0.01f;
+        p->opLevelCVDepth[2] = (float)value * 0.01f;
         break;
     case kParamOp4LevelCVDepth:
-        p->opLevelCVDepth[3] = (float)p->v[parameter] * 0.01f;
+        p->opLevelCVDepth[3] = (float)value * 0.01f;
         break;
 
     // Operator PM CV Depth
     case kParamOp1PMCVDepth:
-        p->opPMCVDepth[0] = (float)p->v[parameter] * 0.01f;
+        p->opPMCVDepth[0] = (float)value * 0.01f;
         break;
     case kParamOp2PMCVDepth:
-        p->opPMCVDepth[1] = (float)p->v[parameter] * 0.01f;
+        p->opPMCVDepth[1] = (float)value * 0.01f;
         break;
     case kParamOp3PMCVDepth:
-        p->opPMCVDepth[2] = (float)p->v[parameter] * 0.01f;
+        p->opPMCVDepth[2] = (float)value * 0.01f;
         break;
     case kParamOp4PMCVDepth:
-        p->opPMCVDepth[3] = (float)p->v[parameter] * 0.01f;
+        p->opPMCVDepth[3] = (float)value * 0.01f;
         break;
 
     // Operator Warp CV Depth
     case kParamOp1WarpCVDepth:
-        p->opWarpCVDepth[0] = (float)p->v[parameter] * 0.01f;
+        p->opWarpCVDepth[0] = (float)value * 0.01f;
         break;
     case kParamOp2WarpCVDepth:
-        p->opWarpCVDepth[1] = (float)p->v[parameter] * 0.01f;
+        p->opWarpCVDepth[1] = (float)value * 0.01f;
         break;
     case kParamOp3WarpCVDepth:
-        p->opWarpCVDepth[2] = (float)p->v[parameter] * 0.01f;
+        p->opWarpCVDepth[2] = (float)value * 0.01f;
         break;
     case kParamOp4WarpCVDepth:
-        p->opWarpCVDepth[3] = (float)p->v[parameter] * 0.01f;
+        p->opWarpCVDepth[3] = (float)value * 0.01f;
         break;
 
     // Operator Fold CV Depth
     case kParamOp1FoldCVDepth:
-        p->opFoldCVDepth[0] = (float)p->v[parameter] * 0.01f;
+        p->opFoldCVDepth[0] = (float)value * 0.01f;
         break;
     case kParamOp2FoldCVDepth:
-        p->opFoldCVDepth[1] = (float)p->v[parameter] * 0.01f;
+        p->opFoldCVDepth[1] = (float)value * 0.01f;
         break;
     case kParamOp3FoldCVDepth:
-        p->opFoldCVDepth[2] = (float)p->v[parameter] * 0.01f;
+        p->opFoldCVDepth[2] = (float)value * 0.01f;
         break;
     case kParamOp4FoldCVDepth:
-        p->opFoldCVDepth[3] = (float)p->v[parameter] * 0.01f;
+        p->opFoldCVDepth[3] = (float)value * 0.01f;
         break;
-    }
-}
 
-// --- Audio ---
+    // Operator fold anti-aliasing
+    case kParamOp1FoldAA:
+    case kParamOp2FoldAA:
+    case kParamOp3FoldAA:
+    case kParamOp4FoldAA:
+        p->opFoldAA[parameter - kParamOp1FoldAA] = value;
+        break;
 
-static void step(
-    _NT_algorithm* self,
-    float* busFrames,
-    int numFramesBy4 )
-{
-    _fourAlgorithm* p = (_fourAlgorithm*)self;
-    int numFrames = numFramesBy4 * 4;
+    case kParamBendRange:
+        p->bendRange = (float)value;
+        p->pitchBendFactor = exp2f( p->pitchBend * p->bendRange * ( 1.0f / 12.0f ) );
+        p->incDirty = true;
+        break;
+    case kParamGlide:
+        p->glideTime = (float)value * 0.001f;
+        break;
+    case kParamGlideMode:
+        p->glideLegato = value;
+        break;
 
-    float* out = busFrames + ( p->v[kParamOutput] - 1 ) * numFrames;
-    bool replace = p->v[kParamOutputMode];
+    case kParamFMMode:
+        p->fmThroughZero = value;
+        break;
+    case kParamFeedbackMode:
+        p->feedbackAverage = value ? 0.5f : 0.0f;
+        break;
+    case kParamOp1FMCVDepth:
+    case kParamOp2FMCVDepth:
+    case kParamOp3FMCVDepth:
+    case kParamOp4FMCVDepth:
+        p->opFMCVDepth[parameter - kParamOp1FMCVDepth] = (float)value * 0.01f;
+        break;
+    case kParamOp1Sync:
+    case kParamOp2Sync:
+    case kParamOp3Sync:
+    case kParamOp4Sync:
+        p->opSync[parameter - kParamOp1Sync] = value;
+        break;
+    }
 
-    int actualRate = p->oversample ? 2 : 1;
-    float sampleRate = (float)NT_globals.sampleRate;
-    float effectiveSampleRate = sampleRate * (float)actualRate;
-    const four::Algorithm& algo = four::algorithms[p->algorithm];
+    if ( parameter >= kParamXMCVRate && parameter < kParamXMCVRate + kNumRatedCV )
+        p->cvRate[parameter - kParamXMCVRate] = value;
+}
 
-    // Read CV buses (0 = not connected)
-    const float* cvVOct     = p->v[kParamVOctCV]     ? busFrames + (p->v[kParamVOctCV] - 1) * numFrames     : NULL;
-    const float* cvXM       = p->v[kParamXMCV]       ? busFrames + (p->v[kParamXMCV] - 1) * numFrames       : NULL;
-    const float* cvFM       = p->v[kParamFMCV]       ? busFrames + (p->v[kParamFMCV] - 1) * numFrames       : NULL;
-    const float* cvSync     = p->v[kParamSyncCV]     ? busFrames + (p->v[kParamSyncCV] - 1) * numFrames     : NULL;
-    const float* cvGlobalVCA= p->v[kParamGlobalVCACV]? busFrames + (p->v[kParamGlobalVCACV] - 1) * numFrames: NULL;
-
-    const float* cvLevel[4];
-    const float* cvPM[4];
-    const float* cvWarp[4];
-    const float* cvFold[4];
-    for ( int op = 0; op < 4; ++op )
+// Copy the current sound into a bank slot
+static void storeProgram( _fourAlgorithm* p, int slot )
+{
+    Program& prog = p->programs->slot[slot];
+    for ( int i = 0; i < kNumProgramParams; ++i )
+        prog.value[i] = p->v[programParams[i]];
+    prog.count = kNumProgramParams;
+}
+
+// Switch to a program in one pass: each value that differs goes straight
+// into the cached state, so the next block plays the new sound, then the
+// host's copy follows for the display and saved preset. Its
+// parameterChanged() calls find the value already applied.
+static void applyProgram( _fourAlgorithm* p, const Program& prog, bool fromAudio )
+{
+    uint32_t index = NT_algorithmIndex( p );
+    for ( int i = 0; i < kNumProgramParams; ++i )
     {
-        int16_t bus;
-        bus = p->v[opLevelCV(op)]; cvLevel[op] = bus ? busFrames + (bus-1)*numFrames : NULL;
-        bus = p->v[opPMCV(op)];    cvPM[op]     = bus ? busFrames + (bus-1)*numFrames : NULL;
-        bus = p->v[opWarpCV(op)];  cvWarp[op]   = bus ? busFrames + (bus-1)*numFrames : NULL;
-        bus = p->v[opFoldCV(op)];  cvFold[op]   = bus ? busFrames + (bus-1)*numFrames : NULL;
+        int parameter = programParams[i];
+        int16_t value = i < prog.count ? prog.value[i] : parameters[parameter].def;
+        if ( value == p->v[parameter] )
+            continue;
+        applyParameter( p, parameter, value );
+        if ( fromAudio )
+            NT_setParameterFromAudio( index, parameter, value );
+        else
+            NT_setParameterFromUi( index, parameter, value );
     }
+}
 
-    // Sync state (edge detection)
-    float prevSync = p->dsBuffer[1];
+static void recallProgram( _fourAlgorithm* p, int slot, bool fromAudio )
+{
+    if ( p->programs->slot[slot].count )
+        applyProgram( p, p->programs->slot[slot], fromAudio );
+}
 
-    // Pre-compute operator frequencies
-    float opFreq[4];
+// Coarse reads as a ratio or in Hz with its operator's Freq Mode. The
+// definition changes here, on the host's parameterChanged() path, never
+// from step()
+static void updateCoarseUnit( _fourAlgorithm* p, int parameter )
+{
     for ( int op = 0; op < 4; ++op )
     {
-        float base = p->baseFrequency * p->pitchBendFactor * p->fineTune;
-        if ( p->opFreqMode[op] == 0 )  // Ratio
-            opFreq[op] = four::calc_frequency_ratio( base, p->opCoarse[op], p->opFine[op] );
-        else  // Fixed
-            opFreq[op] = four::calc_frequency_fixed( p->opFixedHz[op], p->opFine[op] );
+        int base = kParamOp1FreqMode + op * 9;
+        if ( parameter != base + kOpFreqMode )
+            continue;
+        parameters[base + kOpCoarse].unit = p->v[parameter] ? kNT_unitHz : kNT_unitEnum;
+        NT_updateParameterDefinition( NT_algorithmIndex( p ), base + kOpCoarse );
     }
+}
 
-    for ( int i = 0; i < numFrames; ++i )
-    {
-        // --- Per-sample modulations ---
+static void parameterChanged( _NT_algorithm* self, int parameter )
+{
+    _fourAlgorithm* p = (_fourAlgorithm*)self;
+    updateCoarseUnit( p, parameter );
 
-        // V/OCT: overridden by MIDI when gate is on
-        float baseFreq = p->baseFrequency;
-        if ( cvVOct && !p->midiGate )
-            baseFreq = four::voct_to_freq( cvVOct[i] );
+    switch ( parameter )
+    {
+    case kParamProgram:
+        p->program = p->v[parameter] - 1;  // 1-128 → 0-127
+        break;
+    case kParamProgramAction:
+        if ( p->v[parameter] == kProgramActionNone )
+            break;
+        if ( p->v[parameter] == kProgramActionRecall )
+            recallProgram( p, p->program, false );
+        else
+            storeProgram( p, p->program );
+        NT_setParameterFromUi( NT_algorithmIndex( self ), parameter, kProgramActionNone );
+        break;
+    default:
+        if ( parameter < 128 && p->applied[parameter] == p->v[parameter] )
+            break;  // already cached, e.g. by drainUpdates()
+        applyParameter( p, parameter, p->v[parameter] );
+        break;
+    }
+}
 
-        // Recompute op frequencies if V/OCT varies per sample
-        if ( cvVOct || cvFM )
-        {
-            for ( int op = 0; op < 4; ++op )
-            {
-                float base = baseFreq * p->pitchBendFactor * p->fineTune;
-                float fm = cvFM ? cvFM[i] * 1000.0f : 0.0f;
-                if ( p->opFreqMode[op] == 0 )
-                    opFreq[op] = four::calc_frequency_ratio( base, p->opCoarse[op], p->opFine[op] ) + fm;
-                else
-                    opFreq[op] = four::calc_frequency_fixed( p->opCoarse[op], p->opFine[op] ) + fm;
-                if ( opFreq[op] < 0.0f ) opFreq[op] = 0.0f;
-            }
-        }
+// --- Audio ---
 
-        // Sync: reset all phases on rising edge
-        if ( cvSync )
-        {
-            if ( cvSync[i] > 0.5f && prevSync <= 0.5f )
-            {
-                for ( int op = 0; op < 4; ++op )
-                    p->phase[op] = 0.0f;
-            }
-            prevSync = cvSync[i];
-        }
+static void importVoice( _fourAlgorithm* p );  // SysEx voice import, below
 
-        // XM with CV
-        float xm = p->xm;
-        if ( cvXM )
-            xm = fminf( 1.0f, fmaxf( 0.0f, xm + cvXM[i] * 0.2f ) );
+static const int kFadeFrames = 64;            // oversampling switch crossfade
+static const int kControlFrames = 32;         // Control rate CV interval, output frames
+static const float kAutoHoldSeconds = 0.1f;   // before Auto lowers the factor
 
-        // Compute effective operator levels with CV modulation
-        float effectiveLevel[4];
-        for ( int op = 0; op < 4; ++op )
-        {
-            effectiveLevel[op] = p->opLevel[op];
-            if ( cvLevel[op] )
-            {
-                // CV is ±1.0, scale by depth and 0.2 factor for useful range
-                float cvContribution = cvLevel[op][i] * p->opLevelCVDepth[op] * 0.2f;
-                effectiveLevel[op] += cvContribution;
-                effectiveLevel[op] = fmaxf( 0.0f, fminf( 1.0f, effectiveLevel[op] ) );
-            }
-        }
+// CV bus pointers for this step (NULL = not connected)
+struct CVInputs
+{
+    const float* voct;
+    const float* xm;
+    const float* fm;
+    const float* sync;
+    const float* vca;
+    const float* level[4];
+    const float* pm[4];
+    const float* warp[4];
+    const float* fold[4];
+};
 
-        // --- Process operators with optional oversampling ---
-        float outputSample = 0.0f;
+// Smoothed controls for one block as { start, end } ramps, advanced once
+// so both render paths of an oversampling crossfade see the same values
+struct BlockControls
+{
+    int start;
+    int frames;
+    float xm[2];
+    float level[4][2];
+    float warp[4][2];
+    float fold[4][2];
+    float pm[4][2];          // PM CV read at control or block rate
+    float feedback[4];
+    int syncEdges;           // Sync CV edges in scratch.syncEdge
+};
 
-        for ( int os = 0; os < actualRate; ++os )
-        {
-            float opOut[4];
+// Voice state advanced by one render path
+struct VoiceState
+{
+    four::Phase (*phase)[4];
+    four::FeedbackHistory (*prevOutput)[4];
+    float (*foldHistory)[4];
+    float* amp;
+};
 
-            for ( int op = 3; op >= 0; --op )
-            {
-                // Phase increment at effective rate
-                float inc = opFreq[op] / effectiveSampleRate;
+static void rampControl( four::SmoothedValue& v, float dt, float ramp[2] )
+{
+    ramp[0] = v.value;
+    ramp[1] = v.block( dt );
+}
 
-                // Gather modulation from algorithm routing
-                float pm = four::gather_modulation( op, opOut, effectiveLevel, xm, algo );
+static void fillControl( float* dst, const float ramp[2], int n )
+{
+    if ( ramp[0] != ramp[1] )
+        four::block_ramp( dst, ramp[0], ramp[1], n );
+    else
+        four::block_fill( dst, ramp[1], n );
+}
 
-                // Self-feedback
-                pm += four::calc_feedback( p->prevOutput[op], p->opFeedback[op] );
+// Where each rate-selectable input sits in CVInputs, in kRated order
+static const float** ratedInput( CVInputs& cv, int i )
+{
+    if ( i == kRatedXM )
+        return &cv.xm;
+    if ( i == kRatedVCA )
+        return &cv.vca;
+    int op = ( i - kRatedLevel ) & 3;
+    switch ( ( i - kRatedLevel ) >> 2 )
+    {
+    case 0:  return &cv.level[op];
+    case 1:  return &cv.pm[op];
+    case 2:  return &cv.warp[op];
+    default: return &cv.fold[op];
+    }
+}
 
-                // External PM CV
-                if ( cvPM[op] )
-                    pm += cvPM[op][i] * p->opPMCVDepth[op];
+static void addClampedCV( float ramp[2], const float cv[2], float scale )
+{
+    for ( int k = 0; k < 2; ++k )
+        ramp[k] = fminf( 1.0f, fmaxf( 0.0f, ramp[k] + cv[k] * scale ) );
+}
 
-                // Advance phase
-                four::phase_advance( p->phase[op], inc );
+// Control rate CV at frame t of the step: a line through readings every
+// kControlFrames output frames from the step's start, and at its end,
+// starting from the last step's final reading. Blocks never straddle a
+// reading, so a block's two ends trace the line exactly.
+static float controlCV( const float* cv, float from, int numFrames, int t )
+{
+    if ( t >= numFrames )
+        return cv[numFrames - 1];
+    int at = t - t % kControlFrames;
+    int next = at + kControlFrames < numFrames ? at + kControlFrames : numFrames;
+    float a = at ? cv[at - 1] : from;
+    float b = cv[next - 1];
+    return a + ( b - a ) * (float)( t - at ) / (float)( next - at );
+}
 
-                // Compute waveform
-                float modPhase = p->phase[op] + pm;
-                modPhase -= floorf( modPhase );  // Wrap to [0, 1)
+// Fold a control or block rate CV, as volts at the block's start and end,
+// into the block's controls. The sum is clamped at the two ends only and
+// stays a straight line, so the input costs nothing per sample.
+static void applyRatedCV( _fourAlgorithm* p, BlockControls& c, int i, const float cv[2] )
+{
+    if ( i == kRatedXM )
+    {
+        addClampedCV( c.xm, cv, 0.2f );
+        return;
+    }
+    if ( i == kRatedVCA )
+    {
+        four::block_mul_ramp( p->scratch.vca, fmaxf( 0.0f, cv[0] * 0.2f ),
+                              fmaxf( 0.0f, cv[1] * 0.2f ), c.frames );
+        return;
+    }
+    int op = ( i - kRatedLevel ) & 3;
+    switch ( ( i - kRatedLevel ) >> 2 )
+    {
+    case 0:
+        addClampedCV( c.level[op], cv, p->opLevelCVDepth[op] * 0.2f );
+        break;
+    case 1:
+        c.pm[op][0] = cv[0] * p->opPMCVDepth[op];
+        c.pm[op][1] = cv[1] * p->opPMCVDepth[op];
+        break;
+    case 2:
+        addClampedCV( c.warp[op], cv, p->opWarpCVDepth[op] * 0.2f );
+        break;
+    default:
+        addClampedCV( c.fold[op], cv, p->opFoldCVDepth[op] * 0.2f );
+        break;
+    }
+}
 
-                // Warp amount with CV
-                float warp = p->opWarp[op];
-                if ( cvWarp[op] )
-                    warp = fminf( 1.0f, fmaxf( 0.0f, warp + cvWarp[op][i] * p->opWarpCVDepth[op] * 0.2f ) );
+static void setRate( _fourAlgorithm* p, int rate )
+{
+    p->cachedRate = rate;
+    p->invEffectiveRate = 1.0f / ( (float)p->cachedSampleRate * (float)rate );
+    p->incDirty = true;
+}
 
-                float sample;
-                if ( warp > 0.0f )
-                {
-                    if ( p->polyblep )
-                    {
-                        float dt = opFreq[op] / effectiveSampleRate;
-                        sample = four::wave_warp_blep( modPhase, warp, dt );
-                    }
-                    else
-                    {
-                        sample = four::wave_warp( modPhase, warp );
-                    }
-                }
-                else
-                    sample = four::oscillator_sine( modPhase );
+// Switch the main render path to a new oversampling factor. The old
+// factor keeps rendering for kFadeFrames from copies of the voice state,
+// through the chain that holds its filter history; the new factor starts
+// on the other chain from silence.
+static void beginFade( _fourAlgorithm* p, int rate )
+{
+    size_t n = p->numVoices;
+    memcpy( p->voices.fadePhase, p->voices.phase, n * sizeof(four::Phase) * 4 );
+    memcpy( p->voices.fadePrevOutput, p->voices.prevOutput, n * sizeof(four::FeedbackHistory) * 4 );
+    memcpy( p->voices.fadeFoldHistory, p->voices.foldHistory, n * sizeof(float) * 4 );
+    memcpy( p->voices.fadeAmp, p->voices.amp, n * sizeof(float) );
+    p->fadeRate = p->cachedRate;
+    p->fadeFrames = kFadeFrames;
+    p->activeChain ^= 1;
+    p->decimators[p->activeChain].reset();
+    setRate( p, rate );
+}
 
-                // Fold amount with CV
-                float fold = p->opFold[op];
-                if ( cvFold[op] )
-                    fold = fminf( 1.0f, fmaxf( 0.0f, fold + cvFold[op][i] * p->opFoldCVDepth[op] * 0.2f ) );
+// Factor Auto oversampling wants at frame `start`, from the patch's
+// estimated bandwidth (see four::estimate_bandwidth). Ramping values
+// count at whichever end is higher.
+static int autoOversampling( _fourAlgorithm* p, const CVInputs& cv, int start, int maxRate )
+{
+    bool poly = p->numVoices > 1;
+    float hz = 0.0f;
+    for ( int v = 0; v < p->numVoices; ++v )
+    {
+        bool gate = p->voices.gate[v];
+        if ( poly && !gate && p->voices.amp[v] <= 0.0f )
+            continue;
+        float f = ( cv.voct && !poly && !gate ) ? four::VOCT_ZERO_HZ : p->voices.frequency[v];
+        hz = fmaxf( hz, f );
+    }
+    if ( cv.voct )
+        hz *= exp2f( cv.voct[start] );
+    float fm = cv.fm ? fabsf( cv.fm[start] ) * 1000.0f : 0.0f;
 
-                if ( fold > 0.0f )
-                    sample = four::wave_fold( sample, fold, p->opFoldType[op] );
+    four::OperatorRisk risk[4];
+    for ( int op = 0; op < 4; ++op )
+    {
+        four::OperatorRisk& r = risk[op];
+        r.freq = hz * p->opScale[op] + p->opOffset[op] + fm * p->opFMCVDepth[op];
+        r.level = fmaxf( p->opLevel[op].value, p->opLevel[op].target );
+        if ( cv.level[op] )
+            r.level += fabsf( cv.level[op][start] ) * p->opLevelCVDepth[op] * 0.2f;
+        r.feedback = fmaxf( p->opFeedback[op].value, p->opFeedback[op].target );
+        r.warp = fmaxf( p->opWarp[op].value, p->opWarp[op].target );
+        if ( cv.warp[op] )
+            r.warp += fabsf( cv.warp[op][start] ) * p->opWarpCVDepth[op] * 0.2f;
+        r.fold = fmaxf( p->opFold[op].value, p->opFold[op].target );
+        if ( cv.fold[op] )
+            r.fold += fabsf( cv.fold[op][start] ) * p->opFoldCVDepth[op] * 0.2f;
+        r.warp = fminf( r.warp, 1.0f );
+        r.fold = fminf( r.fold, 1.0f );
+        r.foldType = p->opFoldType[op];
+    }
+    float xm = fmaxf( p->xm.value, p->xm.target );
+    if ( cv.xm )
+        xm += fabsf( cv.xm[start] ) * 0.2f;
+
+    float bandwidth = four::estimate_bandwidth( four::algorithms[p->algorithm], risk, xm, p->warpMode );
+    return four::choose_oversampling( bandwidth, (float)p->cachedSampleRate, maxRate );
+}
+
+// Render every voice at `rate` sub-samples per frame and decimate the sum
+// in place, leaving c.frames output samples in scratch.sum. incScale
+// converts the cached increments, which are at the main path's rate.
+static void renderBlock(
+    _fourAlgorithm* p,
+    const BlockControls& c,
+    const CVInputs& cv,
+    four::AlgorithmRenderer render,
+    int rate,
+    float incScale,
+    const VoiceState& vs,
+    four::DecimatorChain& chain )
+{
+    uint32_t t0 = cycleCount();
+    four::BlockScratch& s = p->scratch;
+    int start = c.start;
+    int frames = c.frames;
+    int n = frames * rate;
+    float invRate = p->invEffectiveRate * incScale;
+    bool poly = p->numVoices > 1;
+    four::VoiceRamp ramp( (float)p->cachedSampleRate * (float)rate );
+
+    four::AlgorithmBlock blk;
+    blk.n = n;
+    blk.xm = s.xm;
+
+    // --- Per-sample modulations shared by all voices ---
+
+    // XM with CV
+    fillControl( s.xm, c.xm, n );
+    if ( cv.xm )
+        four::block_add_cv_clamped( s.xm, cv.xm + start, frames, rate, 0.2f );
+
+    for ( int op = 0; op < 4; ++op )
+    {
+        blk.level[op] = s.level[op];
+        blk.pm[op] = s.pm[op];
+
+        // Level: CV is ±1.0, scaled by depth and 0.2 for useful range
+        fillControl( s.level[op], c.level[op], n );
+        if ( cv.level[op] )
+            four::block_add_cv_clamped( s.level[op], cv.level[op] + start, frames, rate,
+                                        p->opLevelCVDepth[op] * 0.2f );
+
+        // External PM CV
+        if ( cv.pm[op] )
+            four::block_from_cv( s.pmCV[op], cv.pm[op] + start, frames, rate,
+                                 0.0f, p->opPMCVDepth[op] );
+        else
+            fillControl( s.pmCV[op], c.pm[op], n );
+
+        four::OperatorBlock& ob = blk.op[op];
+        ob.inc = s.inc[op];
+        ob.foldType = p->opFoldType[op];
+        ob.warpMode = p->warpMode;
+        ob.warpTables = p->warpTables;
+        ob.feedback = c.feedback[op];
+        ob.feedbackAverage = p->feedbackAverage;
+
+        // Warp and fold amounts: constant unless ramping or CV'd
+        ob.warpConst = c.warp[op][0];
+        ob.warp = NULL;
+        if ( cv.warp[op] || c.warp[op][0] != c.warp[op][1] )
+        {
+            fillControl( s.warp[op], c.warp[op], n );
+            if ( cv.warp[op] )
+                four::block_add_cv_clamped( s.warp[op], cv.warp[op] + start, frames, rate,
+                                            p->opWarpCVDepth[op] * 0.2f );
+            ob.warp = s.warp[op];
+        }
+
+        ob.foldConst = c.fold[op][0];
+        ob.fold = NULL;
+        if ( cv.fold[op] || c.fold[op][0] != c.fold[op][1] )
+        {
+            fillControl( s.fold[op], c.fold[op], n );
+            if ( cv.fold[op] )
+                four::block_add_cv_clamped( s.fold[op], cv.fold[op] + start, frames, rate,
+                                            p->opFoldCVDepth[op] * 0.2f );
+            ob.fold = s.fold[op];
+        }
+        ob.sync = NULL;
+        ob.wraps = NULL;
+    }
+
+    // Hard sync: Sync CV edges at this rate, and each source operator's
+    // wraps, which it renders before the operators synced to it
+    if ( c.syncEdges )
+        four::block_from_sync_edges( s.sync, s.syncEdge, frames, rate );
+    for ( int op = 0; op < 4; ++op )
+    {
+        int src = p->opSync[op];
+        if ( src == kSyncCV && c.syncEdges )
+            blk.op[op].sync = s.sync;
+        else if ( src >= kSyncOp )
+        {
+            int from = op + src - kSyncOp + 1;
+            blk.op[op].sync = blk.op[from].wraps = s.wrap[from];
+        }
+    }
 
-                opOut[op] = sample;
-                p->prevOutput[op] = sample;
+    // --- Render voices ---
+    four::block_fill( s.sum, 0.0f, n );
+
+    for ( int v = 0; v < p->numVoices; ++v )
+    {
+        bool gate = p->voices.gate[v];
+        float amp0 = vs.amp[v];
+        if ( poly && !gate && amp0 <= 0.0f )
+            continue;  // Idle voice
+
+        float glide = p->voices.glide[v];
+        if ( cv.voct || cv.fm || glide != 1.0f )
+        {
+            // Per-frame pitch: base × scale + offset (+ FM). A gliding
+            // base steps by one multiply a frame, held at the note.
+            // Through-zero FM lets the increment go negative.
+            bool tracks = cv.voct && ( poly || !gate );
+            float base = p->voices.frequency[v];
+            float to = p->voices.glideTo[v];
+            if ( tracks && !poly )
+            {
+                base = to = four::VOCT_ZERO_HZ;
+                glide = 1.0f;
             }
+            float lo = fminf( base, to ), hi = fmaxf( base, to );
+            float lowest = p->fmThroughZero ? -HUGE_VALF : 0.0f;
+            for ( int j = 0; j < frames; ++j )
+            {
+                float b = tracks ? base * s.pitch[j] : base;
+                float fm = cv.fm ? cv.fm[start + j] * 1000.0f : 0.0f;
+                for ( int op = 0; op < 4; ++op )
+                {
+                    float f = fmaxf( lowest, b * p->opScale[op] + p->opOffset[op]
+                                             + fm * p->opFMCVDepth[op] );
+                    float* inc = s.inc[op] + j * rate;
+                    for ( int os = 0; os < rate; ++os )
+                        inc[os] = f * invRate;
+                }
+                base = fminf( fmaxf( base * glide, lo ), hi );
+            }
+        }
+        else
+        {
+            for ( int op = 0; op < 4; ++op )
+                four::block_fill( s.inc[op], p->voices.inc[v][op] * incScale, n );
+        }
 
-            // --- Sum carriers ---
-            float subSample = four::sum_carriers( opOut, effectiveLevel, algo );
+        // Routing PM is added in place, so each voice starts from the CV
+        memcpy( s.pm, s.pmCV, sizeof(s.pm) );
+        for ( int op = 0; op < 4; ++op )
+            blk.op[op].foldHistory = p->opFoldAA[op] ? &vs.foldHistory[v][op] : NULL;
 
-            // Global VCA with CV
-            float vca = p->globalVCA;
-            if ( cvGlobalVCA )
-                vca *= fmaxf( 0.0f, cvGlobalVCA[i] * 0.2f );
+        render( vs.phase[v], vs.prevOutput[v], blk, s.opOut, s.mix );
 
-            subSample *= vca;
+        if ( poly )
+            vs.amp[v] = ramp.apply( s.sum, s.mix, amp0, gate, n );
+        else
+            four::block_add( s.sum, s.mix, n );
+    }
+
+    uint32_t t1 = cycleCount();
+    chain.process( s.sum, frames, rate, p->decimatorQuality );
+    p->cpuTicks[kCpuOperators] += t1 - t0;
+    p->cpuTicks[kCpuDecimation] += cycleCount() - t1;
+}
+
+// True when the block cannot reach the output: the VCA is closed on
+// every frame, no polyphonic voice is sounding, or every carrier's level
+// (with its CV) is held at zero
+static bool blockIsSilent( _fourAlgorithm* p, const BlockControls& c, const CVInputs& cv )
+{
+    const four::BlockScratch& s = p->scratch;
+    int start = c.start;
+    int frames = c.frames;
 
-            if ( actualRate == 1 )
-                outputSample = subSample;
-            else if ( os == 0 )
-                p->dsBuffer[0] = subSample;
+    bool vcaClosed = true;
+    for ( int j = 0; j < frames && vcaClosed; ++j )
+        vcaClosed = s.vca[j] <= 0.0f || ( cv.vca && cv.vca[start + j] <= 0.0f );
+    if ( vcaClosed )
+        return true;
+
+    if ( p->numVoices > 1 )
+    {
+        bool sounding = false;
+        for ( int v = 0; v < p->numVoices && !sounding; ++v )
+            sounding = p->voices.gate[v] || p->voices.amp[v] > 0.0f;
+        if ( !sounding )
+            return true;
+    }
+
+    const four::Algorithm& a = four::algorithms[p->algorithm];
+    for ( int op = 0; op < 4; ++op )
+    {
+        if ( !a.carrier[op] )
+            continue;
+        if ( c.level[op][0] > 0.0f || c.level[op][1] > 0.0f )
+            return false;
+        if ( cv.level[op] && p->opLevelCVDepth[op] > 0.0f )
+            for ( int j = 0; j < frames; ++j )
+                if ( cv.level[op][start + j] > 0.0f )
+                    return false;
+    }
+    return true;
+}
+
+// Stand-in for renderBlock() on a silent block: moves phases and voice
+// ramps on by what rendering would have, so a note that follows picks up
+// phase-coherently, and leaves c.frames of decimator output in scratch.sum
+// unless the filters are already at rest.
+static void skipBlock(
+    _fourAlgorithm* p,
+    const BlockControls& c,
+    const CVInputs& cv,
+    int rate,
+    const VoiceState& vs,
+    four::DecimatorChain& chain )
+{
+    uint32_t t0 = cycleCount();
+    four::BlockScratch& s = p->scratch;
+    int start = c.start;
+    int frames = c.frames;
+    int n = frames * rate;
+    bool poly = p->numVoices > 1;
+    four::VoiceRamp ramp( (float)p->cachedSampleRate * (float)rate );
+
+    // Last Sync CV edge, in sub-samples from the block start
+    float syncAt = -1.0f;
+    for ( int j = 0; j < frames && c.syncEdges; ++j )
+        if ( s.syncEdge[j] >= 0.0f )
+            syncAt = ( (float)j + s.syncEdge[j] ) * (float)rate;
+
+    for ( int v = 0; v < p->numVoices; ++v )
+    {
+        bool gate = p->voices.gate[v];
+        if ( poly && !gate && vs.amp[v] <= 0.0f )
+            continue;  // Idle voice: renderBlock() leaves it alone too
+
+        // Cycles travelled, in float for the sync timing below, and the
+        // exact fixed-point advance renderBlock() would have accumulated
+        float inc[4];
+        four::Phase step[4];
+        float glide = p->voices.glide[v];
+        if ( cv.voct || cv.fm || glide != 1.0f )
+        {
+            // Sum the per-frame increments renderBlock() would use
+            bool tracks = cv.voct && ( poly || !gate );
+            float base = p->voices.frequency[v];
+            float to = p->voices.glideTo[v];
+            if ( tracks && !poly )
+            {
+                base = to = four::VOCT_ZERO_HZ;
+                glide = 1.0f;
+            }
+            float lo = fminf( base, to ), hi = fmaxf( base, to );
+            float lowest = p->fmThroughZero ? -HUGE_VALF : 0.0f;
+            for ( int op = 0; op < 4; ++op )
+            {
+                inc[op] = 0.0f;
+                step[op] = 0;
+            }
+            for ( int j = 0; j < frames; ++j )
+            {
+                float b = tracks ? base * s.pitch[j] : base;
+                float fm = cv.fm ? cv.fm[start + j] * 1000.0f : 0.0f;
+                for ( int op = 0; op < 4; ++op )
+                {
+                    float f = fmaxf( lowest, b * p->opScale[op] + p->opOffset[op]
+                                             + fm * p->opFMCVDepth[op] );
+                    inc[op] += f;
+                    step[op] += (four::Phase)rate * four::phase_step( f * p->invEffectiveRate );
+                }
+                base = fminf( fmaxf( base * glide, lo ), hi );
+            }
+            for ( int op = 0; op < 4; ++op )
+                inc[op] *= p->invEffectiveRate * (float)rate;  // `rate` sub-samples a frame
+        }
+        else
+        {
+            for ( int op = 0; op < 4; ++op )
+            {
+                inc[op] = p->voices.inc[v][op] * (float)n;
+                step[op] = (four::Phase)n * four::phase_step( p->voices.inc[v][op] );
+            }
+        }
+
+        // A synced phase restarts at its source's last reset or wrap,
+        // taking the increment as steady over the block. Sources come first.
+        float lastReset[4];
+        for ( int op = 3; op >= 0; --op )
+        {
+            int src = p->opSync[op];
+            float at = src == kSyncCV ? syncAt
+                     : src >= kSyncOp ? lastReset[op + src - kSyncOp + 1] : -1.0f;
+            four::Phase& phase = vs.phase[v][op];
+            float from = four::phase_to_float( phase );
+            float to = from + inc[op];
+            float perSample = inc[op] / (float)n;
+            if ( at >= 0.0f )
+            {
+                from = 0.0f;
+                to = perSample * ( (float)n - at );
+            }
+            lastReset[op] = at;
+            if ( ( to >= 1.0f || to < 0.0f ) && perSample != 0.0f )
+            {
+                float edge = to >= 1.0f ? floorf( to ) : ceilf( to );
+                lastReset[op] = fmaxf( at, 0.0f ) + ( edge - from ) / perSample;
+            }
+            if ( at >= 0.0f )
+                phase = four::phase_step( to );
             else
-                outputSample = four::downsample_2x( p->dsBuffer[0], subSample );
+                phase += step[op];
+        }
+        if ( poly )
+            vs.amp[v] = ramp.advance( vs.amp[v], gate, n );
+    }
+
+    uint32_t t1 = cycleCount();
+    if ( !p->idle )
+    {
+        four::block_fill( s.sum, 0.0f, n );
+        chain.process( s.sum, frames, rate, p->decimatorQuality );
+    }
+    p->cpuTicks[kCpuOperators] += t1 - t0;
+    p->cpuTicks[kCpuDecimation] += cycleCount() - t1;
+}
+
+static void setMeterParameter( _fourAlgorithm* p, int parameter, float value )
+{
+    int16_t v = (int16_t)fminf( value + 0.5f, 32767.0f );
+    if ( p->v[parameter] != v )
+        NT_setParameterFromAudio( NT_algorithmIndex( p ), parameter, v );
+}
+
+// Fold this step's ticks into the meters; each finished window goes to
+// the display and the read-only CPU parameters
+static void updateCpuMeters( _fourAlgorithm* p, int numFrames )
+{
+    for ( int i = 0; i < kNumCpuStages; ++i )
+        p->cpu[i].add( p->cpuTicks[i], numFrames );
+    p->cpuWindowFrames += numFrames;
+    if ( p->cpuWindowFrames < kCpuWindowSeconds * (float)p->cachedSampleRate )
+        return;
+    p->cpuWindowFrames = 0;
+    for ( int i = 0; i < kNumCpuStages; ++i )
+        p->cpu[i].publish();
+    p->idlePercent = 100.0f * (float)p->windowSkipped / (float)p->windowBlocks;
+    p->windowBlocks = 0;
+    p->windowSkipped = 0;
+
+    const four::CpuMeter& total = p->cpu[kCpuTotal];
+    setMeterParameter( p, kParamCpuMin, total.min );
+    setMeterParameter( p, kParamCpuAvg, total.avg );
+    setMeterParameter( p, kParamCpuMax, total.max );
+}
+
+// Apply the CCs and Program Changes received since the last block, each
+// parameter once with its latest value, then let the host's copy follow
+// for the display. A Program Change is queued as the Program parameter:
+// CCs before it land first and the program wins.
+struct ApplyUpdate
+{
+    _fourAlgorithm* p;
+    void operator()( int parameter, int16_t value )
+    {
+        if ( parameter == kParamProgram )
+        {
+            p->program = value - 1;
+            recallProgram( p, p->program, true );
         }
+        else
+            applyParameter( p, parameter, value );
+        NT_setParameterFromAudio( NT_algorithmIndex( p ), parameter, value );
+    }
+};
+static_assert( kNumParams <= 256, "ParamQueue events carry an 8-bit parameter index" );
 
-        // Apply DC blocking to final output
-        outputSample = p->dcBlocker.process( outputSample );
+static void drainUpdates( _fourAlgorithm* p )
+{
+    ApplyUpdate apply = { p };
+    p->updates.drain( apply );
+}
+
+// --- MIDI events ---
 
-        // Output
-        if ( replace )
-            out[i] = outputSample;
+static void releaseNote( _fourAlgorithm* p, uint8_t note )
+{
+    for ( int v = 0; v < p->numVoices; ++v )
+    {
+        if ( p->voices.note[v] == note )
+            p->voices.gate[v] = 0;
+    }
+}
+
+// Glide moves a voice's pitch in equal steps of log frequency, so it
+// reaches the note in Glide's time whatever the interval. Each frame is
+// one multiply by a ratio worked out here, once per note.
+static void startGlide( _fourAlgorithm* p, int v, float from, float to, bool glide )
+{
+    VoicePool& vp = p->voices;
+    vp.glideTo[v] = to;
+    float frames = p->glideTime * (float)p->cachedSampleRate;
+    if ( !glide || frames < 1.0f || from == to )
+    {
+        vp.frequency[v] = to;
+        vp.glide[v] = 1.0f;
+        return;
+    }
+    vp.frequency[v] = from;
+    vp.glide[v] = exp2f( log2f( to / from ) / frames );
+    if ( vp.glide[v] == 1.0f )
+        vp.frequency[v] = to;  // a step below float resolution: no glide
+}
+
+// Move gliding voices on by the frames just rendered, with the same
+// clamped multiply as renderBlock(). At the note a voice goes back to the
+// cached increments.
+static void advanceGlides( _fourAlgorithm* p, int frames )
+{
+    VoicePool& vp = p->voices;
+    for ( int v = 0; v < p->numVoices; ++v )
+    {
+        float glide = vp.glide[v];
+        if ( glide == 1.0f )
+            continue;
+        float f = vp.frequency[v];
+        float to = vp.glideTo[v];
+        float lo = fminf( f, to ), hi = fmaxf( f, to );
+        for ( int j = 0; j < frames; ++j )
+            f = fminf( fmaxf( f * glide, lo ), hi );
+        vp.frequency[v] = f;
+        if ( f == to )
+        {
+            vp.glide[v] = 1.0f;
+            p->incDirty = true;
+        }
+    }
+}
+
+// Play a queued note or bend, at its frame inside step()
+static void playMidi( _fourAlgorithm* p, const MidiEvent& e )
+{
+    switch ( e.status & 0xF0 )
+    {
+    case 0x90:  // Note On
+        if ( e.data2 > 0 )
+        {
+            VoicePool& vp = p->voices;
+            bool held = false;
+            for ( int i = 0; i < p->numVoices; ++i )
+                held |= vp.gate[i] != 0;
+            float from = vp.frequency[p->lastVoice];  // mid-glide if still moving
+            int v = four::allocate_voice( e.data1, vp.note, vp.gate, vp.amp, vp.age, p->numVoices );
+            vp.note[v] = e.data1;
+            vp.gate[v] = 1;
+            startGlide( p, v, from, four::midi_note_to_freq( e.data1 ),
+                        p->noteCounter > 0 && ( held || !p->glideLegato ) );
+            vp.age[v] = ++p->noteCounter;
+            p->lastVoice = v;
+            p->incDirty = true;
+        }
         else
-            out[i] += outputSample;
+        {
+            // Velocity 0 = note off
+            releaseNote( p, e.data1 );
+        }
+        break;
+
+    case 0x80:  // Note Off
+        releaseNote( p, e.data1 );
+        break;
+
+    case 0xE0:  // Pitch Bend
+    {
+        int16_t bend = ( (int16_t)e.data2 << 7 ) | e.data1;  // 0-16383
+        p->pitchBend = (float)( bend - 8192 ) / 8192.0f;    // -1 to +1
+        p->pitchBendFactor = exp2f( p->pitchBend * p->bendRange * ( 1.0f / 12.0f ) );
+        p->incDirty = true;
+        break;
+    }
     }
+}
 
-    p->dsBuffer[1] = prevSync;  // Store sync state
+// The API gives MIDI no timestamps, so a message is placed by when it
+// arrives: its time since the last step() began, in frames at the pace of
+// the steps so far. It plays that far into the next block, so the stream
+// runs one block late with its spacing kept instead of snapped to blocks.
+static uint16_t midiFrame( _fourAlgorithm* p )
+{
+    if ( !p->stepTicks )
+        return 0;
+    uint64_t frame = (uint64_t)( cycleCount() - p->stepClock ) * p->stepFrames / p->stepTicks;
+    return frame < 0xFFFF ? (uint16_t)frame : 0xFFFF;
+}
+
+static void queueMidi( _fourAlgorithm* p, uint16_t frame, uint8_t status, uint8_t data1, uint8_t data2 )
+{
+    MidiEvent e = { frame, status, data1, data2 };
+    if ( !p->midiEvents.push( e ) )
+        playMidi( p, e );  // full: late beats lost, above all a lost note off
+}
+
+static void step(
+    _NT_algorithm* self,
+    float* busFrames,
+    int numFramesBy4 )
+{
+    _fourAlgorithm* p = (_fourAlgorithm*)self;
+    int numFrames = numFramesBy4 * 4;
+    uint32_t stepStart = cycleCount();
+    memset( p->cpuTicks, 0, sizeof(p->cpuTicks) );
+    drainUpdates( p );
+    importVoice( p );
+    p->stepTicks = stepStart - p->stepClock;
+    p->stepClock = stepStart;
+    p->stepFrames = numFrames;
+
+    float* out = busFrames + ( p->v[kParamOutput] - 1 ) * numFrames;
+    bool replace = p->v[kParamOutputMode];
+
+    float sampleRate = (float)NT_globals.sampleRate;
+    if ( NT_globals.sampleRate != p->cachedSampleRate )
+    {
+        p->cachedSampleRate = NT_globals.sampleRate;
+        if ( p->cachedRate )
+            setRate( p, p->cachedRate );
+    }
+
+    int maxRate = 1 << p->maxOversample;
+    bool autoRate = p->oversample == kOversampleAuto;
+    int fixedRate = autoRate ? maxRate : 1 << ( p->oversample < p->maxOversample ? p->oversample : p->maxOversample );
+    int holdFrames = (int)( kAutoHoldSeconds * sampleRate );
+    four::AlgorithmRenderer render = four::select_renderer( p->algorithm, p->warpMode );
+
+    // Read CV buses (0 = not connected)
+    CVInputs cv;
+    cv.voct = p->v[kParamVOctCV]      ? busFrames + (p->v[kParamVOctCV] - 1) * numFrames      : NULL;
+    cv.xm   = p->v[kParamXMCV]        ? busFrames + (p->v[kParamXMCV] - 1) * numFrames        : NULL;
+    cv.fm   = p->v[kParamFMCV]        ? busFrames + (p->v[kParamFMCV] - 1) * numFrames        : NULL;
+    cv.sync = p->v[kParamSyncCV]      ? busFrames + (p->v[kParamSyncCV] - 1) * numFrames      : NULL;
+    cv.vca  = p->v[kParamGlobalVCACV] ? busFrames + (p->v[kParamGlobalVCACV] - 1) * numFrames : NULL;
+    for ( int op = 0; op < 4; ++op )
+    {
+        int16_t bus;
+        bus = p->v[opLevelCV(op)]; cv.level[op] = bus ? busFrames + (bus-1)*numFrames : NULL;
+        bus = p->v[opPMCV(op)];    cv.pm[op]    = bus ? busFrames + (bus-1)*numFrames : NULL;
+        bus = p->v[opWarpCV(op)];  cv.warp[op]  = bus ? busFrames + (bus-1)*numFrames : NULL;
+        bus = p->v[opFoldCV(op)];  cv.fold[op]  = bus ? busFrames + (bus-1)*numFrames : NULL;
+    }
+
+    // CV inputs at control or block rate leave the per-sample path: the
+    // renderers see them unconnected and each block gets a ramp between
+    // readings instead. Control reads every kControlFrames output frames,
+    // whatever the oversampling factor, Block once per step(). Auto
+    // oversampling still looks at every input.
+    const CVInputs allInputs = cv;
+    const float* rated[kNumRatedCV];
+    float stepFrom[kNumRatedCV];
+    bool controlRated = false;
+    for ( int i = 0; i < kNumRatedCV; ++i )
+    {
+        const float** input = ratedInput( cv, i );
+        rated[i] = NULL;
+        stepFrom[i] = p->cvHeld[i];
+        if ( *input && p->cvRate[i] != kCVRateAudio )
+        {
+            rated[i] = *input;
+            *input = NULL;
+            controlRated |= p->cvRate[i] == kCVRateControl;
+        }
+        else
+            p->cvHeld[i] = *input ? ( *input )[numFrames - 1] : 0.0f;
+    }
+
+    four::BlockScratch& s = p->scratch;
+    VoiceState live = { p->voices.phase, p->voices.prevOutput, p->voices.foldHistory, p->voices.amp };
+    VoiceState fade = { p->voices.fadePhase, p->voices.fadePrevOutput, p->voices.fadeFoldHistory,
+                        p->voices.fadeAmp };
+
+    // Notes and bends received before this step(); later ones wait
+    uint32_t midiPending = p->midiEvents.pending();
+    uint32_t midiNext = 0;
+
+    for ( int start = 0; start < numFrames; )
+    {
+        // MIDI events due by this frame play now. A block ends just before
+        // the next one, so each lands on its own frame.
+        int midiFrames = numFrames - start;
+        for ( ; midiNext < midiPending; ++midiNext )
+        {
+            const MidiEvent& e = p->midiEvents[midiNext];
+            int at = e.frame < numFrames ? e.frame : numFrames - 1;
+            if ( at > start )
+            {
+                midiFrames = at - start;
+                break;
+            }
+            playMidi( p, e );
+        }
+
+        // Oversampling factor for this block. Changes crossfade from the
+        // old factor; Auto raises it at once but lowers it only after it
+        // has wanted less for kAutoHoldSeconds.
+        if ( !p->fadeRate )
+        {
+            int target = fixedRate;
+            if ( autoRate )
+            {
+                int want = autoOversampling( p, allInputs, start, maxRate );
+                if ( want >= p->cachedRate )
+                    p->autoHold = holdFrames;
+                target = ( want < p->cachedRate && p->autoHold > 0 ) ? p->cachedRate : want;
+            }
+            if ( !p->cachedRate )
+                setRate( p, target );
+            else if ( target != p->cachedRate )
+                beginFade( p, target );
+        }
+        int rate = p->cachedRate;
+        int widest = rate > p->fadeRate ? rate : p->fadeRate;
+
+        int frames = numFrames - start;
+        if ( frames > four::BLOCK_SIZE / widest )
+            frames = four::BLOCK_SIZE / widest;
+        if ( p->fadeRate && frames > p->fadeFrames )
+            frames = p->fadeFrames;
+        if ( frames > midiFrames )
+            frames = midiFrames;
+        if ( controlRated && frames > kControlFrames - start % kControlFrames )
+            frames = kControlFrames - start % kControlFrames;
+
+        // Smoothed parameters advance once per block
+        BlockControls c;
+        c.start = start;
+        c.frames = frames;
+
+        // Sync CV: rising edges through 0.5 V, placed between frames.
+        // The renderers reset the operators synced to it there.
+        c.syncEdges = cv.sync ? four::sync_edges( s.syncEdge, cv.sync + start, p->syncPrev,
+                                                  frames, 0.5f )
+                              : 0;
+        float blockSeconds = (float)frames / sampleRate;
+        bool retune = p->incDirty || p->fineTune.moving();
+        float fineTune = p->fineTune.block( blockSeconds );
+        float opFine[4];
+        for ( int op = 0; op < 4; ++op )
+        {
+            retune |= p->opFine[op].moving();
+            opFine[op] = p->opFine[op].block( blockSeconds );
+            c.feedback[op] = p->opFeedback[op].block( blockSeconds );
+            rampControl( p->opLevel[op], blockSeconds, c.level[op] );
+            rampControl( p->opWarp[op], blockSeconds, c.warp[op] );
+            rampControl( p->opFold[op], blockSeconds, c.fold[op] );
+        }
+        rampControl( p->xm, blockSeconds, c.xm );
+        p->globalVCA.fill( s.vca, blockSeconds, frames );
+        for ( int op = 0; op < 4; ++op )
+            c.pm[op][0] = c.pm[op][1] = 0.0f;
+        for ( int i = 0; i < kNumRatedCV; ++i )
+        {
+            if ( !rated[i] )
+                continue;
+            float ramp[2];
+            if ( p->cvRate[i] == kCVRateControl )
+            {
+                ramp[0] = controlCV( rated[i], stepFrom[i], numFrames, start );
+                ramp[1] = controlCV( rated[i], stepFrom[i], numFrames, start + frames );
+            }
+            else
+            {
+                // Block: a line from the last step's reading to this one's
+                float from = stepFrom[i];
+                float delta = ( rated[i][numFrames - 1] - from ) / (float)numFrames;
+                ramp[0] = from + delta * (float)start;
+                ramp[1] = from + delta * (float)( start + frames );
+            }
+            p->cvHeld[i] = ramp[1];
+            applyRatedCV( p, c, i, ramp );
+        }
+
+        // Rebuild the frequency cache only when something changed
+        if ( retune )
+        {
+            float invRate = p->invEffectiveRate;
+            four::calc_operator_tuning( p->opFreqMode, p->opCoarse, p->opFixedHz, opFine,
+                                        p->pitchBendFactor * fineTune, p->opScale, p->opOffset );
+            for ( int v = 0; v < p->numVoices; ++v )
+                for ( int op = 0; op < 4; ++op )
+                    p->voices.inc[v][op] = ( p->voices.frequency[v] * p->opScale[op]
+                                             + p->opOffset[op] ) * invRate;
+            p->incDirty = false;
+        }
+
+        // V/OCT as a pitch multiplier: sets the pitch when monophonic
+        // (overridden by MIDI when gate is on), transposes every voice when
+        // polyphonic
+        if ( cv.voct )
+        {
+            const float* v = cv.voct + start;
+            switch ( p->voctMode )
+            {
+            case 0:  // Exact
+                for ( int j = 0; j < frames; ++j )
+                    s.pitch[j] = exp2f( v[j] );
+                break;
+            case 1:  // Fast
+                for ( int j = 0; j < frames; ++j )
+                    s.pitch[j] = four::fast_exp2( v[j] );
+                break;
+            default: // Control rate: one exp2f per block, interpolated
+                four::block_ramp( s.pitch, p->voctPrev, exp2f( v[frames - 1] ), frames );
+                break;
+            }
+            p->voctPrev = s.pitch[frames - 1];
+        }
+
+        // --- Render, decimate, crossfade out of the old factor ---
+        // A silent block skips the operators; a crossfade always renders
+        bool silent = !p->fadeRate && blockIsSilent( p, c, cv );
+        ++p->windowBlocks;
+        if ( silent )
+        {
+            ++p->skippedBlocks;
+            ++p->windowSkipped;
+            skipBlock( p, c, cv, rate, live, p->decimators[p->activeChain] );
+        }
+        else
+            p->idle = false;
+
+        if ( p->fadeRate )
+        {
+            renderBlock( p, c, cv, render, p->fadeRate, (float)rate / (float)p->fadeRate,
+                         fade, p->decimators[p->activeChain ^ 1] );
+            memcpy( p->fadeOut, s.sum, frames * sizeof(float) );
+        }
+        if ( !silent )
+            renderBlock( p, c, cv, render, rate, 1.0f, live, p->decimators[p->activeChain] );
+        if ( p->fadeRate )
+        {
+            int done = kFadeFrames - p->fadeFrames;
+            for ( int j = 0; j < frames; ++j )
+            {
+                float g = (float)( done + j + 1 ) * ( 1.0f / kFadeFrames );
+                s.sum[j] = p->fadeOut[j] + ( s.sum[j] - p->fadeOut[j] ) * g;
+            }
+            p->fadeFrames -= frames;
+            if ( p->fadeFrames == 0 )
+                p->fadeRate = 0;
+        }
+        if ( p->autoHold > 0 )
+            p->autoHold -= frames;
+        advanceGlides( p, frames );
+
+        // --- Global VCA, DC block, output ---
+        uint32_t outStart = cycleCount();
+        if ( p->idle )
+        {
+            // Everything has rung out: the output is exactly zero
+            if ( replace )
+                memset( out + start, 0, frames * sizeof(float) );
+            p->cpuTicks[kCpuOutput] += cycleCount() - outStart;
+            start += frames;
+            continue;
+        }
+        float peak = 0.0f;
+        for ( int j = 0; j < frames; ++j )
+        {
+            int i = start + j;
+
+            float outputSample = s.sum[j];
+
+            float vca = s.vca[j];
+            if ( cv.vca )
+                vca *= fmaxf( 0.0f, cv.vca[i] * 0.2f );
+            outputSample *= vca;
+
+            // Apply DC blocking to final output
+            outputSample = p->dcBlocker.process( outputSample );
+            peak = fmaxf( peak, fabsf( outputSample ) );
+
+            if ( replace )
+                out[i] = outputSample;
+            else
+                out[i] += outputSample;
+        }
+        p->cpuTicks[kCpuOutput] += cycleCount() - outStart;
+
+        // The tail of a silent stretch: once the decimators and DC blocker
+        // have decayed, settle them to zero and stop running them
+        if ( silent && peak < kIdleLevel && fabsf( p->dcBlocker.prevInput ) < kIdleLevel )
+        {
+            p->idle = true;
+            p->decimators[0].reset();
+            p->decimators[1].reset();
+            p->dcBlocker.prevInput = 0.0f;
+            p->dcBlocker.prevOutput = 0.0f;
+        }
+
+        start += frames;
+    }
+
+    p->midiEvents.release( midiPending );
+
+    p->cpuTicks[kCpuTotal] = cycleCount() - stepStart;
+    updateCpuMeters( p, numFrames );
 }
 
 // --- MIDI ---
@@ -827,23 +2453,9 @@ static void midiMessage(
     switch ( status )
     {
     case 0x90:  // Note On
-        if ( byte2 > 0 )
-        {
-            p->midiNote = byte1;
-            p->midiGate = 1;
-            p->baseFrequency = four::midi_note_to_freq( byte1 );
-        }
-        else
-        {
-            // Velocity 0 = note off
-            if ( byte1 == p->midiNote )
-                p->midiGate = 0;
-        }
-        break;
-
     case 0x80:  // Note Off
-        if ( byte1 == p->midiNote )
-            p->midiGate = 0;
+    case 0xE0:  // Pitch Bend
+        queueMidi( p, midiFrame( p ), byte0, byte1, byte2 );
         break;
 
     case 0xB0:  // Control Change
@@ -851,47 +2463,428 @@ static void midiMessage(
         int8_t paramIdx = ccToParam[byte1];
         if ( paramIdx >= 0 )
         {
-            int16_t value = scaleCCToParam( byte2, paramIdx );
-            NT_setParameterFromAudio( NT_algorithmIndex(self), paramIdx, value );
+            p->updates.push( paramIdx, scaleCCToParam( byte2, paramIdx ) );
         }
         break;
     }
 
-    case 0xE0:  // Pitch Bend
+    case 0xC0:  // Program Change, recalled by the next step()
+        p->updates.push( kParamProgram, ( byte1 & 0x7F ) + 1 );
+        break;
+
+    }
+}
+
+// --- Presets ---
+
+// The bank is saved with the preset as { "slot": n, "data": record } for
+// each stored slot; parameter values are saved by the host as usual
+static void serialise( _NT_algorithm* self, _NT_jsonStream& stream )
+{
+    _fourAlgorithm* p = (_fourAlgorithm*)self;
+    char record[kProgramRecordChars + 1];
+    stream.addMemberName( "programs" );
+    stream.openArray();
+    for ( int i = 0; i < kNumPrograms; ++i )
     {
-        int16_t bend = ( (int16_t)byte2 << 7 ) | byte1;  // 0-16383
-        float bendNorm = (float)( bend - 8192 ) / 8192.0f;  // -1 to +1
-        // ±2 semitones pitch bend range
-        p->pitchBendFactor = exp2f( bendNorm * 2.0f / 12.0f );
+        const Program& prog = p->programs->slot[i];
+        if ( !prog.count )
+            continue;
+        encodeProgram( prog, record );
+        stream.openObject();
+        stream.addMemberName( "slot" );
+        stream.addNumber( i );
+        stream.addMemberName( "data" );
+        stream.addString( record );
+        stream.closeObject();
+    }
+    stream.closeArray();
+}
+
+// Presets saved before programs existed keep the factory bank
+static bool deserialise( _NT_algorithm* self, _NT_jsonParse& parse )
+{
+    _fourAlgorithm* p = (_fourAlgorithm*)self;
+    int numMembers;
+    if ( !parse.numberOfObjectMembers( numMembers ) )
+        return false;
+    for ( int m = 0; m < numMembers; ++m )
+    {
+        if ( !parse.matchName( "programs" ) )
+        {
+            if ( !parse.skipMember() )
+                return false;
+            continue;
+        }
+        int numPrograms;
+        if ( !parse.numberOfArrayElements( numPrograms ) )
+            return false;
+        p->programs->clear();
+        for ( int i = 0; i < numPrograms; ++i )
+        {
+            int numFields;
+            if ( !parse.numberOfObjectMembers( numFields ) )
+                return false;
+            int slot = -1;
+            Program prog;
+            prog.count = 0;
+            for ( int f = 0; f < numFields; ++f )
+            {
+                const char* data;
+                if ( parse.matchName( "slot" ) )
+                {
+                    if ( !parse.number( slot ) )
+                        return false;
+                }
+                else if ( parse.matchName( "data" ) )
+                {
+                    // Decoded at once; the string is only valid until the next read
+                    if ( !parse.string( data ) || !decodeProgram( data, prog ) )
+                        return false;
+                }
+                else if ( !parse.skipMember() )
+                    return false;
+            }
+            if ( slot < 0 || slot >= kNumPrograms )
+                return false;
+            p->programs->slot[slot] = prog;
+        }
+    }
+    return true;
+}
+
+// --- SysEx voice import ---
+
+// TX81Z frequency ratios by CRS; the DX21/27/100 use the same table
+static const float yamahaRatios[64] = {
+    0.50f, 0.71f, 0.78f, 0.87f, 1.00f, 1.41f, 1.57f, 1.73f,
+    2.00f, 2.82f, 3.00f, 3.14f, 3.46f, 4.00f, 4.24f, 4.71f,
+    5.00f, 5.19f, 5.65f, 6.00f, 6.28f, 6.92f, 7.00f, 7.07f,
+    7.85f, 8.00f, 8.48f, 8.65f, 9.00f, 9.42f, 9.89f, 10.00f,
+    10.38f, 10.99f, 11.00f, 11.30f, 12.00f, 12.11f, 12.56f, 12.72f,
+    13.00f, 13.84f, 14.00f, 14.10f, 14.13f, 15.00f, 15.55f, 15.57f,
+    15.70f, 16.96f, 17.27f, 17.30f, 18.37f, 18.84f, 19.03f, 19.78f,
+    20.41f, 20.76f, 21.20f, 21.98f, 22.49f, 23.55f, 24.22f, 25.95f,
+};
+
+// Dumps list operators 4, 2, 3, 1
+static const uint8_t yamahaOpOrder[4] = { 3, 1, 2, 0 };
+
+// Ratio to Four's coarse index and fine cents: of the coarse steps around
+// the ratio, the one that leaves the least error once fine is clamped to
+// ±100 cents
+static void translateRatio( float ratio, int16_t& coarse, int16_t& cents )
+{
+    const int last = parameters[kParamOp1Coarse].max;
+    int centre = (int)lrintf( ratio * 2.0f + 1.0f );
+    centre = centre < 2 ? 2 : centre > last - 2 ? last - 2 : centre;
+    float best = 1e9f;
+    for ( int idx = centre - 2; idx <= centre + 2; ++idx )
+    {
+        float c = 1200.0f * log2f( ratio / coarseRatio( idx ) );
+        float clamped = fminf( fmaxf( c, -100.0f ), 100.0f );
+        float err = fabsf( c - clamped ) + fabsf( clamped ) * 1e-3f;  // ties: less fine
+        if ( err < best )
+        {
+            best = err;
+            coarse = idx;
+            cents = (int16_t)lrintf( clamped );
+        }
+    }
+}
+
+// Maps a voice onto Four's parameters. Levels follow the 0.75 dB steps of
+// OUT with XM at 100%, so OUT 99 is a full cycle of phase modulation;
+// feedback doubles per FBL step. Envelopes, LFO, velocity, transpose,
+// portamento and the TX81Z's extra waveforms have no counterpart and are
+// dropped.
+static void translateVoice( const YamahaVoice& voice, Program& prog )
+{
+    int16_t values[kNumParams];
+    for ( int i = 0; i < kNumParams; ++i )
+        values[i] = parameters[i].def;
+
+    values[kParamAlgorithm] = voice.alg & 7;
+    values[kParamXM] = 100;
+    values[kParamBendRange] = voice.pbr > 12 ? 12 : voice.pbr;
+    for ( int op = 0; op < 4; ++op )
+    {
+        // Yamaha algorithm 3 is 3→2→1 + 4→1; Four's is 4→2→1 + 3→1
+        int slot = ( voice.alg == 2 && op >= 2 ) ? 5 - op : op;
+        const YamahaOperator& y = voice.op[op];
+        float detune = ( (int)y.det - 3 ) * 2.0f;  // cents
+        int out = y.out > 99 ? 99 : y.out;
+        values[opParam( slot, kOpLevel )] = out
+            ? (int16_t)lrintf( 100.0f * exp2f( ( out - 99 ) * 0.125f ) ) : 0;
+        if ( y.fixed )
+        {
+            int hz = ( ( ( y.crs >> 2 ) << 4 ) + y.fine ) << ( y.fixRange & 7 );
+            values[opParam( slot, kOpFreqMode )] = 1;
+            values[opParam( slot, kOpFixedHz )] = (int16_t)( hz < 1 ? 1 : hz > 9999 ? 9999 : hz );
+            values[opParam( slot, kOpFine )] = (int16_t)detune;
+        }
+        else
+        {
+            float ratio = yamahaRatios[y.crs & 63] * ( 1.0f + y.fine * ( 1.0f / 16.0f ) );
+            translateRatio( ratio * exp2f( detune * ( 1.0f / 1200.0f ) ),
+                            values[opParam( slot, kOpCoarse )], values[opParam( slot, kOpFine )] );
+        }
+        if ( op == 3 && voice.fbl )
+            values[opParam( slot, kOpFeedback )] = (int16_t)( 100 >> ( 7 - ( voice.fbl & 7 ) ) );
+    }
+
+    for ( int i = 0; i < kNumProgramParams; ++i )
+        prog.value[i] = values[programParams[i]];
+    prog.count = kNumProgramParams;
+}
+
+static void parseVCED( const SysExReceiver& rx, YamahaVoice& voice )
+{
+    for ( int k = 0; k < 4; ++k )
+    {
+        const uint8_t* b = rx.record + k * 13;
+        YamahaOperator& y = voice.op[yamahaOpOrder[k]];
+        y.out = b[10];
+        y.crs = b[11];
+        y.det = b[12];
+        y.fixed = rx.acedValid ? rx.aced[k][0] : 0;
+        y.fixRange = rx.acedValid ? rx.aced[k][1] : 0;
+        y.fine = rx.acedValid ? rx.aced[k][2] : 0;
+    }
+    voice.alg = rx.record[52];
+    voice.fbl = rx.record[53];
+    voice.pbr = rx.record[64];
+}
+
+// One VMEM voice; bytes 73-80 carry the TX81Z extras and are zero from
+// the DX21/27/100
+static void parseVMEM( const uint8_t* rec, YamahaVoice& voice )
+{
+    for ( int k = 0; k < 4; ++k )
+    {
+        const uint8_t* b = rec + k * 10;
+        YamahaOperator& y = voice.op[yamahaOpOrder[k]];
+        y.out = b[7];
+        y.crs = b[8] & 0x3F;
+        y.det = b[9] & 0x07;
+        y.fixed = ( rec[73 + k * 2] >> 3 ) & 1;
+        y.fixRange = rec[73 + k * 2] & 0x07;
+        y.fine = rec[74 + k * 2] & 0x0F;
+    }
+    voice.alg = rec[40] & 0x07;
+    voice.fbl = ( rec[40] >> 3 ) & 0x07;
+    voice.pbr = rec[47] & 0x0F;
+}
+
+static bool startSysEx( SysExReceiver& rx )
+{
+    const uint8_t* h = rx.header;
+    if ( h[0] != 0x43 || ( h[1] & 0xF0 ) != 0 )
+        return false;
+    rx.format = h[2];
+    rx.expected = ( h[3] << 7 ) | h[4];
+    switch ( rx.format )
+    {
+    case kSysExVCED: return rx.expected == kVCEDBytes;
+    case kSysExVMEM: return rx.expected == kVMEMVoiceBytes * kVMEMVoices;
+    case kSysExACED: return rx.expected == kACEDBytes;
+    }
+    return false;
+}
+
+static void sysExData( SysExReceiver& rx, uint8_t byte )
+{
+    rx.sum += byte;
+    if ( rx.format == kSysExVMEM )
+    {
+        int i = rx.received % kVMEMVoiceBytes;
+        rx.record[i] = byte;
+        if ( i == kVMEMVoiceBytes - 1 )
+            parseVMEM( rx.record, rx.staged[rx.numStaged++] );
+    }
+    else
+        rx.record[rx.received] = byte;
+    ++rx.received;
+}
+
+// Checksum passed: a single voice becomes the current sound, a bank fills
+// programs from the selected one on. Both wait for step() to translate
+// them; a bank that doesn't fit behind voices still waiting is dropped
+// whole.
+static void finishSysEx( _fourAlgorithm* p, SysExReceiver& rx )
+{
+    switch ( rx.format )
+    {
+    case kSysExACED:
+        rx.acedValid = memcmp( rx.record, "LM  8976AE", 10 ) == 0;
+        if ( rx.acedValid )
+            memcpy( rx.aced, rx.record + 10, sizeof(rx.aced) );
+        break;
+    case kSysExVCED:
+    {
+        ImportedVoice in;
+        parseVCED( rx, in.voice );
+        in.slot = -1;
+        rx.acedValid = false;
+        rx.imported.push( in );
         break;
     }
+    case kSysExVMEM:
+    {
+        int count = rx.numStaged < kNumPrograms - p->program ? rx.numStaged : kNumPrograms - p->program;
+        if ( (int)rx.imported.space() < count )
+            break;
+        for ( int i = 0; i < count; ++i )
+        {
+            ImportedVoice in = { rx.staged[i], (int16_t)( p->program + i ) };
+            rx.imported.push( in );
+        }
+        break;
+    }
+    }
+}
+
+// One received voice per block onto Four's parameters: into its bank
+// slot, or straight to the current sound
+static void importVoice( _fourAlgorithm* p )
+{
+    four::EventRing<ImportedVoice, 2 * kVMEMVoices>& imported = p->sysex->imported;
+    if ( imported.pending() == 0 )
+        return;
+    const ImportedVoice& in = imported[0];
+    Program prog;
+    translateVoice( in.voice, prog );
+    if ( in.slot < 0 )
+        applyProgram( p, prog, true );
+    else
+        p->programs->slot[in.slot] = prog;
+    imported.release( 1 );
+}
+
+static void midiSysEx( _NT_algorithm* self, const uint8_t* data, uint32_t count )
+{
+    _fourAlgorithm* p = (_fourAlgorithm*)self;
+    SysExReceiver& rx = *p->sysex;
+    for ( uint32_t i = 0; i < count; ++i )
+    {
+        uint8_t byte = data[i];
+        if ( byte >= 0xF8 )
+            continue;  // realtime bytes may interleave
+        if ( byte & 0x80 )
+        {
+            rx.state = byte == 0xF0 ? kSysExHeader : kSysExIdle;
+            rx.headerLength = 0;
+            continue;
+        }
+        switch ( rx.state )
+        {
+        case kSysExIdle:
+            // Some hosts strip the F0: a Yamaha ID starts a message too
+            if ( byte != 0x43 )
+                break;
+            rx.state = kSysExHeader;
+            rx.headerLength = 0;
+            // fall through
+        case kSysExHeader:
+            rx.header[rx.headerLength++] = byte;
+            if ( rx.headerLength == sizeof(rx.header) )
+            {
+                rx.state = startSysEx( rx ) ? kSysExData : kSysExSkip;
+                rx.sum = 0;
+                rx.received = 0;
+                rx.numStaged = 0;
+            }
+            break;
+        case kSysExData:
+            sysExData( rx, byte );
+            if ( rx.received == rx.expected )
+                rx.state = kSysExChecksum;
+            break;
+        case kSysExChecksum:
+            if ( ( ( rx.sum + byte ) & 0x7F ) == 0 )
+                finishSysEx( p, rx );
+            rx.state = kSysExIdle;
+            break;
+        case kSysExSkip:
+            break;
+        }
     }
 }
 
+// --- Display ---
+
+static char* appendText( char* dst, const char* text )
+{
+    while ( *text )
+        *dst++ = *text++;
+    *dst = 0;
+    return dst;
+}
+
+static char* appendInt( char* dst, float value )
+{
+    return dst + NT_intToString( dst, (int32_t)( value + 0.5f ) );
+}
+
+// CPU meters below the parameter display: the whole step as min / avg /
+// max cycles per sample, then the average per stage, the oversampling
+// factor in use and the share of blocks skipped as silent
+static bool draw( _NT_algorithm* self )
+{
+    _fourAlgorithm* p = (_fourAlgorithm*)self;
+    const four::CpuMeter& total = p->cpu[kCpuTotal];
+    char line[80];
+    char* s = line;
+
+    s = appendText( s, "CPU cyc/smp  min " );
+    s = appendInt( s, total.min );
+    s = appendText( s, "  avg " );
+    s = appendInt( s, total.avg );
+    s = appendText( s, "  max " );
+    s = appendInt( s, total.max );
+    NT_drawText( 0, 54, line, 15, kNT_textLeft, kNT_textTiny );
+
+    s = line;
+    s = appendText( s, "ops " );
+    s = appendInt( s, p->cpu[kCpuOperators].avg );
+    s = appendText( s, "  decimate " );
+    s = appendInt( s, p->cpu[kCpuDecimation].avg );
+    s = appendText( s, "  output " );
+    s = appendInt( s, p->cpu[kCpuOutput].avg );
+    s = appendText( s, "  at " );
+    s = appendInt( s, (float)p->cachedRate );
+    s = appendText( s, "x  idle " );
+    s = appendInt( s, p->idlePercent );
+    s = appendText( s, "%" );
+    NT_drawText( 0, 63, line, 10, kNT_textLeft, kNT_textTiny );
+
+    return false;
+}
+
 // --- Factory ---
 
 static const _NT_factory factory = {
     .guid = NT_MULTICHAR('F', 'o', 'u', 'r'),
     .name = "Four",
     .description = "Four v" FOUR_VERSION " - 4-op FM synthesizer",
-    .numSpecifications = 0,
-    .specifications = NULL,
-    .calculateStaticRequirements = NULL,
-    .initialise = NULL,
+    .numSpecifications = ARRAY_SIZE(specifications),
+    .specifications = specifications,
+    .calculateStaticRequirements = calculateStaticRequirements,
+    .initialise = initialise,
     .calculateRequirements = calculateRequirements,
     .construct = construct,
     .parameterChanged = parameterChanged,
     .step = step,
-    .draw = NULL,
+    .draw = draw,
     .midiRealtime = NULL,
     .midiMessage = midiMessage,
     .tags = kNT_tagInstrument,
     .hasCustomUi = NULL,
     .customUi = NULL,
     .setupUi = NULL,
-    .serialise = NULL,
-    .deserialise = NULL,
-    .midiSysEx = NULL,
+    .serialise = serialise,
+    .deserialise = deserialise,
+    .midiSysEx = midiSysEx,
     .parameterUiPrefix = NULL,
     .parameterString = NULL,
 };
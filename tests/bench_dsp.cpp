@@ -0,0 +1,332 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include <chrono>
+#include <complex>
+#include <algorithm>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_CYCLES 1
+#endif
+
+#include "../dsp.h"
+#include "reference.h"
+
+// Desktop benchmark for the operator render paths.
+// Reports ns and cycles per sub-sample for the per-sample scalar path, the
+// generic block renderer and the per-algorithm renderers over the same
+// patch, for every algorithm. Cycles come from the TSC on x86 and are
+// omitted elsewhere.
+//
+// Then, for each oversampling factor and decimator, the alias energy and
+// the cost per output frame (render + decimation) of a few harsh patches.
+
+static const int kBlocks = 20000;
+static const int kRuns = 5;       // best of
+
+static four::BlockScratch scratch;
+
+static inline uint64_t read_cycles()
+{
+#ifdef HAVE_CYCLES
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+struct Timing
+{
+    double ns;        // per sub-sample
+    double cycles;    // per sub-sample, 0 if unavailable
+};
+
+// Controls are filled once; each block only restores the PM buffers that
+// the renderers consume, so every path carries the same overhead.
+template <typename Render>
+static Timing time_run( Render render, int warpMode )
+{
+    four::AlgorithmBlock b;
+    four::Phase phase[4] = { 0, 0, 0, 0 };
+    four::FeedbackHistory prev[4] = {};
+    float pmInit[4][four::BLOCK_SIZE];
+    volatile float sink = 0.0f;
+
+    fill_patch_block( scratch, b, four::BLOCK_SIZE, warpMode, 0 );
+    memcpy( pmInit, scratch.pm, sizeof(pmInit) );
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    uint64_t c0 = read_cycles();
+    for ( int blk = 0; blk < kBlocks; ++blk )
+    {
+        memcpy( scratch.pm, pmInit, sizeof(pmInit) );
+        render( phase, prev, b );
+        sink = sink + scratch.mix[0];
+    }
+    uint64_t c1 = read_cycles();
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+    double samples = (double)kBlocks * four::BLOCK_SIZE;
+    Timing t;
+    t.ns = std::chrono::duration<double, std::nano>( t1 - t0 ).count() / samples;
+    t.cycles = (double)( c1 - c0 ) / samples;
+    return t;
+}
+
+template <typename Render>
+static Timing time_per_sample( Render render, int warpMode )
+{
+    Timing best = time_run( render, warpMode );
+    for ( int r = 1; r < kRuns; ++r )
+    {
+        Timing t = time_run( render, warpMode );
+        if ( t.ns < best.ns ) best = t;
+    }
+    return best;
+}
+
+struct ScalarRender
+{
+    int algo;
+    void operator()( four::Phase* phase, four::FeedbackHistory* prev, const four::AlgorithmBlock& b ) const
+    {
+        render_algorithm_scalar( four::algorithms[algo], phase, prev, b, scratch.mix );
+    }
+};
+
+struct BlockRender
+{
+    int algo;
+    void operator()( four::Phase* phase, four::FeedbackHistory* prev, const four::AlgorithmBlock& b ) const
+    {
+        four::render_algorithm_block( four::algorithms[algo], phase, prev, b, scratch.opOut, scratch.mix );
+    }
+};
+
+struct FixedRender
+{
+    four::AlgorithmRenderer render;
+    void operator()( four::Phase* phase, four::FeedbackHistory* prev, const four::AlgorithmBlock& b ) const
+    {
+        render( phase, prev, b, scratch.opOut, scratch.mix );
+    }
+};
+
+// --- Oversampling: alias energy vs cost ---
+
+// f0 = 23 × 48000 / 4096 Hz, so with integer ratios every harmonic lands
+// exactly on a multiple of bin 23 of a 4096-point DFT at 48 kHz, and the
+// phase increments are exact in float at every oversampling factor.
+// Aliases fold onto the other bins (23 is coprime with 4096).
+static const int kAliasN = 4096;
+static const int kAliasBin = 23;
+static const int kAliasWarmup = 4096;
+
+struct AliasPatch
+{
+    const char* name;
+    int algorithm;
+    float xm;
+    float ratio[4];
+    float feedback[4];
+    float warp[4];
+    float fold[4];
+    float feedbackAverage;   // 0 Last Sample, 0.5 DX Average
+};
+
+static const AliasPatch aliasPatches[] = {
+    { "sines",    7, 1.0f, { 1, 2, 3, 4 }, { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, 0 },
+    { "pad",      5, 0.2f, { 1, 2, 1, 1 }, { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, 0 },
+    { "bell",     2, 0.4f, { 1, 3, 1, 4 }, { 0, 0, 0, 0.1f }, { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, 0 },
+    { "feedback", 7, 1.0f, { 1, 2, 3, 4 }, { 0.3f, 0.25f, 0, 0 }, { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, 0 },
+    { "fb DX",    7, 1.0f, { 1, 2, 3, 4 }, { 0.3f, 0.25f, 0, 0 }, { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, 0.5f },
+    { "fold",     4, 1.0f, { 1, 3, 1, 2 }, { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, { 0.9f, 0, 0.7f, 0 }, 0 },
+    { "warp",     7, 1.0f, { 1, 2, 3, 4 }, { 0, 0, 0, 0 }, { 0.7f, 1.0f, 0.5f, 0.9f }, { 0, 0, 0, 0 }, 0 },
+};
+
+// Factor Auto oversampling would pick for a patch
+static int auto_factor( const AliasPatch& patch )
+{
+    four::OperatorRisk op[4];
+    for ( int i = 0; i < 4; ++i )
+    {
+        op[i].freq = 48000.0f * kAliasBin / kAliasN * patch.ratio[i];
+        op[i].level = 0.8f;
+        op[i].feedback = patch.feedback[i];
+        op[i].warp = patch.warp[i];
+        op[i].fold = patch.fold[i];
+        op[i].foldType = 0;
+    }
+    float bandwidth = four::estimate_bandwidth( four::algorithms[patch.algorithm], op, patch.xm, four::WARP_NAIVE );
+    return four::choose_oversampling( bandwidth, 48000.0f, 8 );
+}
+
+struct AliasResult
+{
+    double aliasDb;   // energy off the harmonic bins, relative to total
+    double ns;        // per output frame
+};
+
+static AliasResult measure_alias( const AliasPatch& patch, int factor, int quality,
+                                  int warpMode )
+{
+    static float out[kAliasN];
+    four::AlgorithmBlock b;
+    four::AlgorithmRenderer render = four::select_renderer( patch.algorithm, warpMode );
+    four::Decimator4x s4;
+    four::Decimator8x s8;
+    four::DecimatorChain chain;
+    chain.s4 = &s4;
+    chain.s8 = &s8;
+    four::Phase phase[4] = { 0, 0, 0, 0 };
+    four::FeedbackHistory prev[4] = {};
+    int n = four::BLOCK_SIZE;
+    int frames = n / factor;
+
+    b.n = n;
+    b.xm = scratch.xm;
+    four::block_fill( scratch.xm, patch.xm, n );
+    for ( int op = 0; op < 4; ++op )
+    {
+        four::block_fill( scratch.inc[op],
+                          (float)kAliasBin * patch.ratio[op] / ( (float)kAliasN * factor ), n );
+        four::block_fill( scratch.level[op], 0.8f, n );
+        b.level[op] = scratch.level[op];
+        b.pm[op] = scratch.pm[op];
+        four::OperatorBlock& o = b.op[op];
+        o.inc = scratch.inc[op];
+        o.warp = NULL;
+        o.fold = NULL;
+        o.warpConst = patch.warp[op];
+        o.foldConst = patch.fold[op];
+        o.feedback = patch.feedback[op];
+        o.feedbackAverage = patch.feedbackAverage;
+        o.foldType = 0;
+        o.warpMode = (uint8_t)warpMode;
+        o.warpTables = &warp_tables();
+        o.foldHistory = NULL;
+    }
+
+    int total = kAliasWarmup + kAliasN;
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for ( int start = 0; start < total; start += frames )
+    {
+        memset( scratch.pm, 0, sizeof(scratch.pm) );
+        render( phase, prev, b, scratch.opOut, scratch.mix );
+        chain.process( scratch.mix, frames, factor, quality );
+        for ( int j = 0; j < frames; ++j )
+            if ( start + j >= kAliasWarmup )
+                out[start + j - kAliasWarmup] = scratch.mix[j];
+    }
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+    // Alias energy: everything below 20 kHz that isn't DC or a harmonic bin.
+    // Folded products between 20 and 24 kHz are inaudible and don't count.
+    static std::complex<double> spec[kAliasN];
+    for ( int i = 0; i < kAliasN; ++i )
+        spec[i] = out[i];
+    fft( spec, kAliasN );
+    double power = 0.0, alias = 0.0;
+    for ( int bin = 0; bin <= kAliasN / 2; ++bin )
+    {
+        double e = std::norm( spec[bin] );
+        power += e;
+        if ( bin % kAliasBin != 0 && bin < kAliasN * 20000 / 48000 )
+            alias += e;
+    }
+
+    AliasResult r;
+    r.aliasDb = 10.0 * log10( fmax( alias, 1e-30 ) / power );
+    r.ns = std::chrono::duration<double, std::nano>( t1 - t0 ).count() / total;
+    return r;
+}
+
+static AliasResult best_alias( const AliasPatch& patch, int factor, int quality,
+                               int warpMode = four::WARP_NAIVE )
+{
+    AliasResult best = measure_alias( patch, factor, quality, warpMode );
+    for ( int r = 1; r < kRuns; ++r )
+    {
+        AliasResult t = measure_alias( patch, factor, quality, warpMode );
+        if ( t.ns < best.ns ) best.ns = t.ns;
+    }
+    return best;
+}
+
+int main()
+{
+    four::init_sine_table();
+
+    printf( "Four DSP benchmark (per sub-sample: ns / cycles)\n\n" );
+    static const char* warpModeNames[] = { "off", "PolyBLEP", "wavetable" };
+    for ( int mode = 0; mode <= four::WARP_TABLE; ++mode )
+    {
+        printf( "Warp anti-aliasing %s\n", warpModeNames[mode] );
+        printf( "  algo          scalar           block           fixed  speedup\n" );
+        for ( int a = 0; a < 11; ++a )
+        {
+            ScalarRender scalar = { a };
+            BlockRender block = { a };
+            FixedRender fixed = { four::select_renderer( a, mode ) };
+            Timing t0 = time_per_sample( scalar, mode );
+            Timing t1 = time_per_sample( block, mode );
+            Timing t2 = time_per_sample( fixed, mode );
+            printf( "  %4d  %6.1f / %6.1f  %6.1f / %6.1f  %6.1f / %6.1f  %6.2fx\n", a + 1,
+                    t0.ns, t0.cycles, t1.ns, t1.cycles, t2.ns, t2.cycles, t0.ns / t2.ns );
+        }
+        printf( "\n" );
+    }
+
+    printf( "Oversampling (alias energy dB / ns per output frame)\n" );
+    printf( "  patch         1x          2x IIR          2x FIR          4x IIR"
+            "          4x FIR          8x IIR          8x FIR       Auto (IIR)\n" );
+    int numPatches = sizeof(aliasPatches) / sizeof(aliasPatches[0]);
+    double fixedNs = 0.0, autoNs = 0.0;
+    for ( int i = 0; i < numPatches; ++i )
+    {
+        const AliasPatch& patch = aliasPatches[i];
+        AliasResult r = best_alias( patch, 1, four::DECIMATE_IIR );
+        printf( "  %-8s %6.1f /%6.0f", patch.name, r.aliasDb, r.ns );
+        for ( int factor = 2; factor <= 8; factor *= 2 )
+        {
+            for ( int q = 0; q < 2; ++q )
+            {
+                r = best_alias( patch, factor, q );
+                printf( "  %6.1f /%6.0f", r.aliasDb, r.ns );
+                if ( factor == 2 && q == four::DECIMATE_IIR )
+                    fixedNs += r.ns;
+            }
+        }
+        int factor = auto_factor( patch );
+        r = best_alias( patch, factor, four::DECIMATE_IIR );
+        autoNs += r.ns;
+        printf( "  %dx %6.1f /%6.0f\n", factor, r.aliasDb, r.ns );
+    }
+    printf( "  mean ns per frame: fixed 2x %.0f, Auto %.0f\n",
+            fixedNs / numPatches, autoNs / numPatches );
+
+    printf( "\nWarp anti-aliasing (alias energy dB / ns per output frame, IIR decimation)\n" );
+    printf( "  patch       1x off     1x PolyBLEP     2x PolyBLEP    1x wavetable    2x wavetable\n" );
+    for ( int i = 0; i < numPatches; ++i )
+    {
+        const AliasPatch& patch = aliasPatches[i];
+        bool warped = false;
+        for ( int op = 0; op < 4; ++op )
+            warped |= patch.warp[op] > 0.0f;
+        if ( !warped )
+            continue;
+        static const int runs[5][2] = {
+            { 1, four::WARP_NAIVE }, { 1, four::WARP_POLYBLEP }, { 2, four::WARP_POLYBLEP },
+            { 1, four::WARP_TABLE }, { 2, four::WARP_TABLE },
+        };
+        printf( "  %-8s", patch.name );
+        for ( int r = 0; r < 5; ++r )
+        {
+            AliasResult res = best_alias( patch, runs[r][0], four::DECIMATE_IIR, runs[r][1] );
+            printf( "  %6.1f /%6.0f", res.aliasDb, res.ns );
+        }
+        printf( "\n" );
+    }
+    return 0;
+}
@@ -0,0 +1,208 @@
+#ifndef FOUR_TESTS_GOLDEN_H
+#define FOUR_TESTS_GOLDEN_H
+
+// Generated by `make golden` (test_dsp --golden). Band levels of the
+// double-precision reference in 0.1 dB, one row per golden_patch() index.
+
+static const int16_t goldenBands[198][8] = {
+    {  -130,   -67,   -48,   -75,  -114,  -113,  -138,  -142 },
+    {  -127,   -67,   -47,   -75,  -116,  -113,  -140,  -147 },
+    {  -314,  -234,  -138,   -72,   -48,   -69,  -111,   -83 },
+    {  -325,  -210,  -132,   -69,   -48,   -75,  -110,   -83 },
+    {  -219,  -303,  -306,  -291,  -145,   -76,   -59,   -28 },
+    {  -264,  -246,  -308,  -198,  -124,   -71,   -52,   -37 },
+    {   -26,  -134,   -91,   -96,  -115,  -137,  -153,  -158 },
+    {   -25,  -134,   -91,   -96,  -115,  -138,  -155,  -169 },
+    {   -63,   -68,   -98,  -138,   -92,   -94,  -113,  -100 },
+    {   -60,   -67,  -100,  -134,   -90,   -95,  -121,  -105 },
+    {   -67,  -296,  -302,   -60,   -89,  -137,  -101,   -58 },
+    {   -59,  -294,  -348,   -64,   -98,  -131,   -92,   -62 },
+    {   -20,  -118,  -117,  -145,   -94,  -126,  -184,  -181 },
+    {   -20,  -117,  -119,  -146,   -94,  -125,  -184,  -181 },
+    {  -350,   -21,  -164,  -117,  -116,  -146,  -102,  -100 },
+    {  -387,   -20,  -178,  -113,  -127,  -146,   -99,  -107 },
+    {  -356,  -360,  -321,   -20,  -163,  -116,  -116,   -69 },
+    {  -351,  -307,  -390,   -16,  -195,  -107,  -138,   -78 },
+    {   -54,   -75,   -75,  -145,   -75,  -112,  -133,  -165 },
+    {   -54,   -75,   -75,  -143,   -76,  -112,  -132,  -159 },
+    {  -409,   -55,  -245,   -75,   -75,  -140,   -74,   -87 },
+    {  -368,   -56,  -267,   -77,   -75,  -130,   -77,   -81 },
+    {  -298,  -316,  -311,   -56,  -140,   -81,   -64,   -52 },
+    {  -356,  -283,  -286,   -74,  -155,   -80,   -66,   -39 },
+    {   -12,  -182,  -145,  -152,  -103,  -139,  -164,  -190 },
+    {   -13,  -184,  -145,  -150,  -104,  -139,  -163,  -186 },
+    {   -86,   -37,   -74,  -176,  -145,  -148,  -101,  -117 },
+    {   -86,   -37,   -74,  -179,  -143,  -144,  -104,  -113 },
+    {   -86,  -354,  -283,   -39,   -79,  -149,  -125,   -70 },
+    {   -81,  -277,  -304,   -38,   -81,  -165,  -120,   -73 },
+    {   -19,  -128,   -95,  -149,  -100,  -156,  -184,  -189 },
+    {   -19,  -127,   -96,  -150,  -100,  -154,  -186,  -189 },
+    {  -442,   -20,  -173,  -128,   -95,  -145,   -99,  -132 },
+    {  -440,   -19,  -181,  -124,   -98,  -150,  -100,  -130 },
+    {  -405,  -272,  -326,   -20,  -165,  -124,   -90,   -80 },
+    {  -313,  -328,  -432,   -15,  -199,  -108,  -106,   -97 },
+    {  -167,  -110,  -101,   -58,   -44,   -85,  -175,  -193 },
+    {  -167,  -110,  -101,   -58,   -43,   -85,  -177,  -196 },
+    {  -372,  -181,  -219,  -112,  -100,   -59,   -41,   -82 },
+    {  -369,  -175,  -220,  -110,  -101,   -58,   -41,   -82 },
+    {  -347,  -263,  -299,  -174,  -148,  -104,   -91,   -14 },
+    {  -395,  -294,  -291,  -202,  -143,   -93,   -80,   -17 },
+    {   -56,  -105,   -91,   -71,   -64,  -111,  -204,  -224 },
+    {   -56,  -105,   -90,   -71,   -64,  -112,  -204,  -218 },
+    {  -104,  -165,   -83,  -112,   -87,   -66,   -67,  -103 },
+    {  -104,  -168,   -83,  -113,   -85,   -66,   -67,  -103 },
+    {   -95,  -280,  -339,  -152,  -101,  -142,   -70,   -28 },
+    {  -100,  -363,  -305,  -137,  -121,  -143,   -57,   -31 },
+    {   -31,  -171,   -71,   -83,  -103,  -152,  -192,  -201 },
+    {   -31,  -170,   -70,   -83,  -104,  -155,  -191,  -198 },
+    {  -369,  -121,   -38,  -165,   -70,   -83,  -100,  -130 },
+    {  -380,  -119,   -38,  -162,   -68,   -86,  -101,  -134 },
+    {  -290,  -364,  -355,  -107,   -44,  -134,   -66,   -55 },
+    {  -276,  -383,  -400,   -95,   -50,  -114,   -53,   -69 },
+    {  -151,  -114,   -95,   -37,   -75,   -81,  -185,  -181 },
+    {  -151,  -113,   -94,   -37,   -75,   -81,  -184,  -193 },
+    {  -363,  -216,  -147,  -112,   -95,   -40,   -70,   -76 },
+    {  -462,  -223,  -144,  -109,   -90,   -38,   -71,   -86 },
+    {  -324,  -331,  -376,  -213,  -150,   -89,  -103,   -13 },
+    {  -544,  -310,  -330,  -182,  -126,   -95,   -99,   -15 },
+    {   -58,  -129,   -56,   -73,   -84,  -122,  -196,  -209 },
+    {   -58,  -127,   -56,   -73,   -84,  -123,  -198,  -209 },
+    {   -93,  -143,   -98,  -145,   -54,   -72,   -83,  -110 },
+    {   -90,  -146,   -95,  -143,   -55,   -71,   -85,  -117 },
+    {   -88,  -315,  -377,  -136,  -107,  -208,   -56,   -34 },
+    {   -81,  -381,  -361,  -135,  -109,  -165,   -54,   -39 },
+    {   -40,  -116,   -53,   -85,  -120,  -171,  -217,  -212 },
+    {   -40,  -116,   -53,   -85,  -120,  -171,  -217,  -222 },
+    {  -373,  -109,   -52,  -113,   -53,   -85,  -122,  -138 },
+    {  -366,  -110,   -49,  -113,   -53,   -86,  -124,  -150 },
+    {  -278,  -377,  -407,  -107,   -62,   -97,   -50,   -60 },
+    {  -258,  -342,  -472,  -103,   -49,   -95,   -52,   -78 },
+    {  -142,   -22,   -73,  -127,   -95,  -212,  -337,  -313 },
+    {  -142,   -22,   -73,  -127,   -95,  -211,  -327,  -315 },
+    {  -354,  -144,  -271,   -22,   -73,  -126,   -95,  -199 },
+    {  -354,  -145,  -269,   -22,   -73,  -128,   -95,  -194 },
+    {  -256,  -490,  -491,  -142,  -262,   -22,   -76,   -74 },
+    {  -256,  -435,  -361,  -146,  -252,   -22,   -75,   -75 },
+    {   -54,   -44,   -81,   -91,  -122,  -234,  -282,  -279 },
+    {   -54,   -44,   -81,   -91,  -122,  -234,  -281,  -284 },
+    {   -69,  -116,  -154,   -44,   -81,   -91,  -127,  -211 },
+    {   -70,  -116,  -153,   -44,   -81,   -92,  -126,  -211 },
+    {   -64,  -482,  -404,  -118,  -155,   -46,   -80,   -76 },
+    {   -65,  -355,  -378,  -118,  -149,   -45,   -81,   -77 },
+    {   -27,   -97,   -55,  -145,  -161,  -209,  -243,  -245 },
+    {   -27,   -97,   -55,  -146,  -161,  -209,  -245,  -257 },
+    {  -363,   -27,  -281,   -97,   -54,  -147,  -167,  -185 },
+    {  -367,   -27,  -280,   -97,   -54,  -149,  -168,  -200 },
+    {  -269,  -441,  -368,   -27,  -259,  -100,   -53,  -121 },
+    {  -269,  -634,  -467,   -26,  -270,   -98,   -52,  -135 },
+    {  -152,   -27,   -83,   -73,  -121,  -178,  -197,  -200 },
+    {  -152,   -27,   -82,   -74,  -121,  -179,  -199,  -211 },
+    {  -371,  -283,  -155,   -27,   -83,   -74,  -118,  -145 },
+    {  -376,  -298,  -151,   -26,   -82,   -76,  -120,  -160 },
+    {  -277,  -363,  -329,  -277,  -153,   -28,   -83,   -54 },
+    {  -274,  -565,  -653,  -332,  -140,   -22,   -80,   -72 },
+    {   -60,   -33,  -111,   -89,  -131,  -191,  -209,  -213 },
+    {   -60,   -33,  -111,   -90,  -131,  -192,  -211,  -224 },
+    {  -155,   -87,  -103,   -33,  -114,   -89,  -128,  -159 },
+    {  -156,   -86,  -102,   -32,  -114,   -91,  -130,  -174 },
+    {  -141,  -340,  -358,   -87,  -102,   -34,  -121,   -67 },
+    {  -140,  -457,  -620,   -81,   -99,   -30,  -122,   -86 },
+    {   -24,   -48,  -198,  -145,  -156,  -215,  -232,  -236 },
+    {   -24,   -47,  -199,  -146,  -156,  -216,  -234,  -249 },
+    {  -369,   -25,  -202,   -48,  -196,  -146,  -152,  -182 },
+    {  -376,   -24,  -199,   -47,  -201,  -150,  -154,  -200 },
+    {  -276,  -375,  -413,   -25,  -202,   -49,  -174,  -109 },
+    {  -276,  -618,  -798,   -23,  -189,   -46,  -188,  -144 },
+    {  -170,    -5,  -134,  -170,  -192,  -237,  -270,  -279 },
+    {  -170,    -5,  -134,  -170,  -193,  -238,  -274,  -300 },
+    {  -375,  -224,  -185,    -5,  -133,  -171,  -203,  -219 },
+    {  -379,  -225,  -186,    -4,  -134,  -173,  -206,  -242 },
+    {  -279,  -374,  -409,  -222,  -185,    -5,  -128,  -148 },
+    {  -278,  -544,  -759,  -227,  -187,    -4,  -131,  -170 },
+    {   -54,   -19,  -155,  -170,  -193,  -238,  -272,  -280 },
+    {   -54,   -19,  -155,  -170,  -194,  -239,  -276,  -306 },
+    {  -157,   -90,   -85,   -19,  -154,  -171,  -205,  -220 },
+    {  -157,   -90,   -85,   -19,  -155,  -173,  -209,  -248 },
+    {  -143,  -377,  -411,   -90,   -85,   -20,  -146,  -149 },
+    {  -143,  -544,  -691,   -89,   -85,   -19,  -150,  -172 },
+    {   -23,   -45,  -182,  -179,  -201,  -245,  -280,  -287 },
+    {   -22,   -45,  -182,  -179,  -201,  -247,  -285,  -318 },
+    {  -373,   -23,  -237,   -45,  -182,  -181,  -213,  -228 },
+    {  -377,   -22,  -238,   -44,  -183,  -183,  -217,  -260 },
+    {  -277,  -385,  -417,   -22,  -236,   -46,  -174,  -158 },
+    {  -276,  -646,  -826,   -22,  -241,   -45,  -179,  -185 },
+    {  -146,    -6,  -115,  -189,  -213,  -239,  -268,  -276 },
+    {  -146,    -6,  -115,  -189,  -214,  -240,  -271,  -297 },
+    {  -380,  -190,  -166,    -6,  -114,  -187,  -209,  -214 },
+    {  -380,  -190,  -165,    -6,  -114,  -188,  -213,  -235 },
+    {  -276,  -396,  -461,  -189,  -164,    -7,  -109,  -154 },
+    {  -275,  -548,  -764,  -189,  -164,    -6,  -110,  -179 },
+    {   -57,   -19,  -129,  -189,  -214,  -238,  -267,  -275 },
+    {   -57,   -18,  -129,  -189,  -214,  -239,  -272,  -300 },
+    {  -158,  -101,   -83,   -19,  -128,  -185,  -209,  -213 },
+    {  -157,  -101,   -83,   -19,  -128,  -186,  -214,  -238 },
+    {  -143,  -398,  -466,  -101,   -83,   -20,  -120,  -154 },
+    {  -142,  -544,  -692,  -101,   -82,   -20,  -123,  -180 },
+    {   -25,   -42,  -151,  -199,  -221,  -244,  -273,  -281 },
+    {   -25,   -42,  -151,  -199,  -221,  -245,  -278,  -311 },
+    {  -374,   -26,  -198,   -42,  -150,  -196,  -216,  -219 },
+    {  -374,   -25,  -198,   -42,  -150,  -198,  -221,  -248 },
+    {  -270,  -406,  -476,   -25,  -196,   -44,  -143,  -163 },
+    {  -269,  -653,  -832,   -24,  -196,   -43,  -147,  -195 },
+    {  -152,   -69,   -77,   -68,   -58,  -113,  -163,  -160 },
+    {  -153,   -69,   -77,   -68,   -57,  -113,  -161,  -162 },
+    {  -319,  -156,  -206,   -72,   -73,   -67,   -73,   -73 },
+    {  -349,  -163,  -228,   -69,   -74,   -67,   -60,   -92 },
+    {  -329,  -350,  -331,  -141,  -155,  -100,   -95,   -14 },
+    {  -319,  -332,  -492,  -167,  -232,   -74,   -72,   -22 },
+    {   -40,   -69,  -106,  -100,   -85,  -144,  -186,  -181 },
+    {   -39,   -68,  -107,  -100,   -85,  -145,  -185,  -189 },
+    {  -147,  -102,   -59,   -69,   -96,  -104,   -95,  -101 },
+    {  -139,  -105,   -56,   -66,  -102,  -102,   -86,  -130 },
+    {  -150,  -309,  -355,   -93,   -57,   -94,   -98,   -45 },
+    {  -135,  -386,  -484,   -91,   -57,   -77,   -89,   -58 },
+    {   -17,   -91,  -128,  -125,  -123,  -177,  -212,  -206 },
+    {   -17,   -91,  -129,  -125,  -123,  -178,  -213,  -218 },
+    {  -376,  -107,   -23,   -89,  -122,  -129,  -141,  -132 },
+    {  -424,  -108,   -22,   -89,  -124,  -128,  -132,  -163 },
+    {  -387,  -322,  -372,  -101,   -28,   -87,  -108,   -81 },
+    {  -467,  -443,  -566,  -100,   -24,   -86,  -108,  -101 },
+    {   -45,   -79,   -64,   -84,  -127,  -155,  -179,  -190 },
+    {   -45,   -78,   -64,   -84,  -127,  -155,  -181,  -199 },
+    {  -450,  -103,   -58,   -80,   -64,   -84,  -124,  -129 },
+    {  -470,  -104,   -58,   -77,   -63,   -85,  -124,  -137 },
+    {  -404,  -264,  -323,  -106,   -54,   -80,   -63,   -64 },
+    {  -388,  -355,  -438,  -115,   -56,   -71,   -60,   -69 },
+    {   -28,   -81,   -88,  -100,  -126,  -177,  -195,  -205 },
+    {   -28,   -81,   -88,  -100,  -126,  -177,  -198,  -213 },
+    {  -220,   -95,   -38,   -84,   -88,  -100,  -125,  -148 },
+    {  -218,   -95,   -38,   -82,   -88,  -100,  -127,  -158 },
+    {  -212,  -300,  -331,   -86,   -38,   -94,   -85,   -75 },
+    {  -216,  -373,  -430,   -83,   -38,   -88,   -81,   -86 },
+    {   -20,   -87,  -103,  -103,  -153,  -203,  -219,  -225 },
+    {   -20,   -87,  -103,  -103,  -154,  -202,  -222,  -233 },
+    {  -476,  -100,   -28,   -86,  -101,  -105,  -150,  -172 },
+    {  -505,  -101,   -27,   -86,  -102,  -105,  -155,  -182 },
+    {  -430,  -346,  -366,   -94,   -30,   -82,   -95,   -93 },
+    {  -378,  -490,  -483,   -93,   -27,   -78,   -96,  -111 },
+    {  -140,  -162,   -95,   -51,   -34,  -139,  -201,  -208 },
+    {  -138,  -161,   -94,   -51,   -35,  -139,  -198,  -193 },
+    {  -405,  -148,  -213,  -160,   -97,   -50,   -35,  -120 },
+    {  -376,  -149,  -185,  -158,   -93,   -50,   -39,  -109 },
+    {  -362,  -283,  -377,  -145,  -195,  -128,   -96,   -10 },
+    {  -382,  -286,  -339,  -146,  -148,  -121,   -95,   -12 },
+    {   -75,  -124,   -61,   -63,   -64,  -150,  -193,  -197 },
+    {   -74,  -123,   -61,   -63,   -64,  -151,  -196,  -212 },
+    {   -99,  -189,  -121,  -133,   -59,   -61,   -64,  -132 },
+    {   -98,  -184,  -122,  -129,   -59,   -62,   -64,  -142 },
+    {   -96,  -254,  -336,  -162,  -144,  -152,   -50,   -32 },
+    {   -96,  -396,  -367,  -140,  -154,  -134,   -47,   -36 },
+    {   -44,  -160,   -52,   -80,   -95,  -173,  -199,  -203 },
+    {   -44,  -160,   -52,   -80,   -95,  -173,  -202,  -218 },
+    {  -447,  -115,   -55,  -155,   -51,   -79,   -96,  -145 },
+    {  -449,  -113,   -53,  -155,   -51,   -79,   -97,  -160 },
+    {  -395,  -328,  -331,  -101,   -63,  -126,   -46,   -57 },
+    {  -364,  -358,  -463,   -93,   -58,  -115,   -45,   -70 },
+};
+
+#endif // FOUR_TESTS_GOLDEN_H
@@ -0,0 +1,181 @@
+#ifndef FOUR_HOST_API_H
+#define FOUR_HOST_API_H
+
+// Host stand-in for the Disting NT plugin API (distingNT_API/include).
+// Declares just what four.cpp uses, with the same names and shapes, so it
+// can be built and driven on the desktop by render_four.cpp, which also
+// provides the NT_* function definitions. Not a complete API.
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define ARRAY_SIZE(x) ( sizeof(x) / sizeof((x)[0]) )
+#define NT_MULTICHAR(a,b,c,d) \
+    ( (uint32_t)(a) << 0 | (uint32_t)(b) << 8 | (uint32_t)(c) << 16 | (uint32_t)(d) << 24 )
+
+// --- Parameters ---
+
+enum _NT_unit
+{
+    kNT_unitNone, kNT_unitEnum, kNT_unitDb, kNT_unitDb_minInf, kNT_unitPercent,
+    kNT_unitHz, kNT_unitSemitones, kNT_unitCents, kNT_unitMs, kNT_unitSeconds,
+    kNT_unitFrames, kNT_unitMIDINote, kNT_unitMillivolts, kNT_unitVolts, kNT_unitBPM,
+    kNT_unitAudioInput = 100, kNT_unitCvInput, kNT_unitAudioOutput, kNT_unitCvOutput,
+    kNT_unitOutputMode,
+};
+
+enum { kNT_scalingNone, kNT_scaling10, kNT_scaling100, kNT_scaling1000 };
+
+struct _NT_parameter
+{
+    const char* name;
+    int16_t min;
+    int16_t max;
+    int16_t def;
+    uint8_t unit;
+    uint8_t scaling;
+    char const * const * enumStrings;
+};
+
+// Buses 1-12 are inputs, 13-20 outputs, 21-28 aux
+#define NT_PARAMETER_CV_INPUT( n, m, i ) \
+    { .name = n, .min = m, .max = 28, .def = i, .unit = kNT_unitCvInput, .scaling = 0, .enumStrings = NULL },
+#define NT_PARAMETER_AUDIO_OUTPUT_WITH_MODE( n, m, i ) \
+    { .name = n, .min = m, .max = 28, .def = i, .unit = kNT_unitAudioOutput, .scaling = 0, .enumStrings = NULL }, \
+    { .name = n " mode", .min = 0, .max = 1, .def = 0, .unit = kNT_unitOutputMode, .scaling = 0, .enumStrings = NULL },
+
+struct _NT_parameterPage
+{
+    const char* name;
+    uint8_t numParams;
+    uint8_t group;
+    uint8_t unused[2];
+    const uint8_t* params;
+};
+
+struct _NT_parameterPages
+{
+    uint32_t numPages;
+    const _NT_parameterPage* pages;
+};
+
+// --- Algorithm ---
+
+struct _NT_algorithm
+{
+    const _NT_parameter* parameters;
+    const _NT_parameterPages* parameterPages;
+    const int16_t* vIncludingCommon;
+    const int16_t* v;
+};
+
+struct _NT_globals
+{
+    uint32_t sampleRate;
+    uint32_t maxFramesPerStep;
+    float* workBuffer;
+    uint32_t workBufferSizeBytes;
+};
+
+// Writable on the host so the harness can change the sample rate
+extern _NT_globals NT_globals;
+extern uint8_t NT_screen[128 * 64];
+
+// Memory shared by every instance of a factory, set up once by initialise()
+struct _NT_staticRequirements
+{
+    uint32_t dram;
+};
+
+struct _NT_staticMemoryPtrs
+{
+    uint8_t* dram;
+};
+
+struct _NT_algorithmRequirements
+{
+    uint32_t numParameters;
+    uint32_t sram;
+    uint32_t dram;
+    uint32_t dtc;
+    uint32_t itc;
+};
+
+struct _NT_algorithmMemoryPtrs
+{
+    uint8_t* sram;
+    uint8_t* dram;
+    uint8_t* dtc;
+    uint8_t* itc;
+};
+
+enum _NT_specificationType { kNT_typeGeneric };
+
+struct _NT_specification
+{
+    const char* name;
+    int32_t min;
+    int32_t max;
+    int32_t def;
+    int32_t type;
+};
+
+// --- Drawing ---
+
+enum _NT_textSize { kNT_textTiny, kNT_textNormal, kNT_textLarge };
+enum _NT_textAlignment { kNT_textLeft, kNT_textCentre, kNT_textRight };
+
+// --- Presets ---
+
+class _NT_jsonStream;
+class _NT_jsonParse;
+struct _NT_uiData;
+
+// --- Factory ---
+
+enum { kNT_tagInstrument = 1 };
+enum _NT_selector { kNT_selector_version, kNT_selector_numFactories, kNT_selector_factoryInfo };
+enum { kNT_apiVersionCurrent = 9 };
+
+struct _NT_factory
+{
+    uint32_t guid;
+    const char* name;
+    const char* description;
+    uint32_t numSpecifications;
+    const _NT_specification* specifications;
+    void (*calculateStaticRequirements)( _NT_staticRequirements& req );
+    void (*initialise)( _NT_staticMemoryPtrs& ptrs, const _NT_staticRequirements& req );
+    void (*calculateRequirements)( _NT_algorithmRequirements& req, const int32_t* specifications );
+    _NT_algorithm* (*construct)( const _NT_algorithmMemoryPtrs& ptrs,
+                                 const _NT_algorithmRequirements& req,
+                                 const int32_t* specifications );
+    void (*parameterChanged)( _NT_algorithm* self, int p );
+    void (*step)( _NT_algorithm* self, float* busFrames, int numFramesBy4 );
+    bool (*draw)( _NT_algorithm* self );
+    void (*midiRealtime)( _NT_algorithm* self, uint8_t byte );
+    void (*midiMessage)( _NT_algorithm* self, uint8_t byte0, uint8_t byte1, uint8_t byte2 );
+    uint32_t tags;
+    bool (*hasCustomUi)( _NT_algorithm* self );
+    void (*customUi)( _NT_algorithm* self, const _NT_uiData& data );
+    void (*setupUi)( _NT_algorithm* self, void* pots );
+    void (*serialise)( _NT_algorithm* self, _NT_jsonStream& stream );
+    bool (*deserialise)( _NT_algorithm* self, _NT_jsonParse& parse );
+    void (*midiSysEx)( _NT_algorithm* self, const uint8_t* data, uint32_t count );
+    int (*parameterUiPrefix)( _NT_algorithm* self, int p, char* buff );
+    int (*parameterString)( _NT_algorithm* self, int p, int v, char* buff );
+};
+
+// --- Host services ---
+
+uint32_t NT_algorithmIndex( const _NT_algorithm* algorithm );
+uint32_t NT_parameterOffset( void );
+void NT_setParameterFromAudio( uint32_t algorithmIndex, uint32_t parameter, int16_t value );
+void NT_setParameterFromUi( uint32_t algorithmIndex, uint32_t parameter, int16_t value );
+void NT_updateParameterDefinition( uint32_t algorithmIndex, uint32_t parameter );
+void NT_drawText( int x, int y, const char* str, int colour = 15,
+                  _NT_textAlignment align = kNT_textLeft, _NT_textSize size = kNT_textNormal );
+int NT_intToString( char* buffer, int32_t value );
+int NT_floatToString( char* buffer, float value, int decimalPlaces = 2 );
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef FOUR_HOST_SERIALISATION_H
+#define FOUR_HOST_SERIALISATION_H
+
+// Host stand-in for distingnt/serialisation.h: the JSON writer handed to
+// serialise() and the reader handed to deserialise(), with the module's
+// method names. render_four.cpp implements them over a std::string; the
+// public data members are host only.
+
+#include <stdint.h>
+#include <string>
+
+class _NT_jsonStream
+{
+public:
+    _NT_jsonStream() : needComma( false ) {}
+
+    void openArray();
+    void closeArray();
+    void openObject();
+    void closeObject();
+    void addMemberName( const char* name );
+    void addNumber( int value );
+    void addNumber( float value );
+    void addString( const char* str );
+    void addBoolean( bool value );
+    void addNull();
+
+    std::string text;
+
+private:
+    void separate();
+    bool needComma;
+};
+
+class _NT_jsonParse
+{
+public:
+    explicit _NT_jsonParse( const char* json ) : pos( json ) {}
+
+    bool numberOfObjectMembers( int& num );
+    bool numberOfArrayElements( int& num );
+    bool matchName( const char* name );
+    bool skipMember();
+    bool number( int& value );
+    bool number( float& value );
+    bool boolean( bool& value );
+    bool string( const char*& value );
+
+private:
+    bool open( char bracket, char close, int& num );
+    const char* pos;
+    std::string str;
+};
+
+#endif
@@ -0,0 +1,333 @@
+#ifndef FOUR_TESTS_REFERENCE_H
+#define FOUR_TESTS_REFERENCE_H
+
+// Reference renderers used to validate and benchmark optimized paths.
+
+#include <math.h>
+#include <complex>
+#include <algorithm>
+
+#include "../dsp.h"
+
+// Band-limited warp tables, built on first use and shared
+inline const four::WarpTables& warp_tables()
+{
+    static four::WarpTables* tables = NULL;
+    if ( !tables )
+    {
+        tables = new four::WarpTables;
+        tables->build();
+    }
+    return *tables;
+}
+
+// Per-sample scalar path: all four operators interleaved one sub-sample
+// at a time, as step() rendered before block processing. Reads the same
+// controls as render_algorithm_block but leaves b.pm untouched.
+inline void render_algorithm_scalar(
+    const four::Algorithm& algo,
+    four::Phase phase[4],
+    four::FeedbackHistory prevOutput[4],
+    const four::AlgorithmBlock& b,
+    float* mix )
+{
+    for ( int i = 0; i < b.n; ++i )
+    {
+        float opOut[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        float level[4];
+        for ( int op = 0; op < 4; ++op )
+            level[op] = b.level[op][i];
+
+        for ( int op = 3; op >= 0; --op )
+        {
+            const four::OperatorBlock& o = b.op[op];
+
+            float pm = four::gather_modulation( op, opOut, level, b.xm[i], algo );
+            pm += four::calc_feedback( prevOutput[op], o.feedback, o.feedbackAverage );
+            pm += b.pm[op][i];
+
+            four::phase_advance( phase[op], o.inc[i] );
+
+            four::Phase fixedPhase = phase[op] + four::phase_step( pm );
+            float modPhase = four::phase_to_float( fixedPhase );
+
+            float warp = o.warp ? o.warp[i] : o.warpConst;
+            float sample;
+            if ( warp > 0.0f )
+            {
+                if ( o.warpMode == four::WARP_TABLE )
+                    sample = four::wave_warp_table( o.warpTables->level( o.inc[i] ), modPhase, warp );
+                else if ( o.warpMode == four::WARP_POLYBLEP )
+                    sample = four::wave_warp_blep( modPhase, warp, o.inc[i] );
+                else
+                    sample = four::wave_warp( modPhase, warp );
+            }
+            else
+                sample = four::phase_sine( fixedPhase );
+
+            float fold = o.fold ? o.fold[i] : o.foldConst;
+            if ( o.foldHistory )
+                sample = four::wave_fold_adaa( sample, fold, o.foldType, *o.foldHistory );
+            else if ( fold > 0.0f )
+                sample = four::wave_fold( sample, fold, o.foldType );
+
+            opOut[op] = sample;
+            prevOutput[op].push( sample );
+        }
+
+        mix[i] = four::sum_carriers( opOut, level, algo );
+    }
+}
+
+// Fill one block of controls for a representative patch: feedback, warp
+// and fold on several operators, with per-sample CV on some of them.
+// Call before every block (render_algorithm_block consumes b.pm).
+inline void fill_patch_block(
+    four::BlockScratch& s,
+    four::AlgorithmBlock& b,
+    int n,
+    int warpMode,
+    int blockIndex )
+{
+    static const float ratio[4]    = { 1.0f, 2.0f, 3.5f, 1.0f };
+    static const float feedback[4] = { 0.0f, 0.0f, 0.2f, 0.3f };
+    static const float warp[4]     = { 0.0f, 0.5f, 0.0f, 0.8f };
+    static const float fold[4]     = { 0.3f, 0.6f, 0.0f, 0.0f };
+
+    b.n = n;
+    b.xm = s.xm;
+    four::block_fill( s.xm, 0.6f, n );
+
+    for ( int op = 0; op < 4; ++op )
+    {
+        four::block_fill( s.inc[op], 220.0f * ratio[op] / 96000.0f, n );
+        four::block_fill( s.level[op], 0.8f, n );
+        four::block_fill( s.pm[op], 0.0f, n );
+        b.level[op] = s.level[op];
+        b.pm[op] = s.pm[op];
+
+        four::OperatorBlock& o = b.op[op];
+        o.inc = s.inc[op];
+        o.warp = NULL;
+        o.fold = NULL;
+        o.warpConst = warp[op];
+        o.foldConst = fold[op];
+        o.feedback = feedback[op];
+        o.foldType = (uint8_t)( op % 3 );
+        o.warpMode = (uint8_t)warpMode;
+        o.warpTables = &warp_tables();
+        o.foldHistory = NULL;
+    }
+
+    // Per-sample CV: warp sweep on op 2, fold sweep on op 1, PM on op 1,
+    // level tremolo on op 4
+    for ( int i = 0; i < n; ++i )
+    {
+        float t = (float)( blockIndex * n + i ) / 4800.0f;
+        s.warp[1][i] = 0.5f + 0.5f * sinf( t * 3.0f );
+        s.fold[0][i] = 0.5f + 0.5f * sinf( t * 5.0f );
+        s.pm[0][i] = 0.1f * sinf( t * 200.0f );
+        s.level[3][i] = 0.5f + 0.4f * sinf( t * 7.0f );
+    }
+    b.op[1].warp = s.warp[1];
+    b.op[0].fold = s.fold[0];
+}
+
+// --- Double-precision reference ---
+//
+// The operator math of dsp.h in double precision with exact sines: no
+// table, no block structure. Only the phase accumulator stays 32-bit fixed
+// point, as in the plugin, so the increment rounds the same way in both and
+// naive warp edges land on the same samples.
+// Optimized kernels are judged against this, spectrally, by the golden tests.
+
+struct ReferencePatch
+{
+    double hz;            // base frequency
+    double sampleRate;    // sub-sample rate
+    double ratio[4];
+    double level[4];
+    double feedback[4];
+    double warp[4];
+    double fold[4];
+    int foldType;         // all operators
+    double xm;
+    bool polyblep;
+};
+
+inline double reference_sine( double phase )
+{
+    return sin( 2.0 * M_PI * phase );
+}
+
+inline double reference_soft_clip( double x )
+{
+    if ( x < -3.0 ) return -1.0;
+    if ( x >  3.0 ) return  1.0;
+    double x2 = x * x;
+    return x * ( 27.0 + x2 ) / ( 27.0 + 9.0 * x2 );
+}
+
+inline double reference_polyblep( double phase, double dt )
+{
+    if ( phase < dt )
+    {
+        double t = phase / dt;
+        return t + t - t * t - 1.0;
+    }
+    if ( phase > 1.0 - dt )
+    {
+        double t = ( phase - 1.0 ) / dt;
+        return t * t + t + t + 1.0;
+    }
+    return 0.0;
+}
+
+inline double reference_warp( double phase, double warp, double dt, bool polyblep )
+{
+    double tri = phase < 0.25 ? phase * 4.0 : phase < 0.75 ? 2.0 - phase * 4.0 : phase * 4.0 - 4.0;
+    double saw = 2.0 * phase - 1.0;
+    double pls = phase < 0.5 ? 1.0 : -1.0;
+    if ( polyblep )
+    {
+        saw -= reference_polyblep( phase, dt );
+        double shifted = phase + 0.5;
+        if ( shifted >= 1.0 ) shifted -= 1.0;
+        pls += reference_polyblep( phase, dt ) - reference_polyblep( shifted, dt );
+    }
+
+    if ( warp <= 1.0 / 3.0 )
+        return reference_sine( phase ) + warp * 3.0 * ( tri - reference_sine( phase ) );
+    if ( warp <= 2.0 / 3.0 )
+        return tri + ( warp - 1.0 / 3.0 ) * 3.0 * ( saw - tri );
+    return saw + ( warp - 2.0 / 3.0 ) * 3.0 * ( pls - saw );
+}
+
+inline double reference_fold( double x, double amount, int type )
+{
+    x *= 1.0 + amount * 4.0;
+    if ( type == 0 || ( type == 1 && x >= 0.0 ) )
+        return sin( x * M_PI * 0.5 );
+    return reference_soft_clip( x );
+}
+
+// Render n sub-samples of a constant patch from phase 0
+inline void render_reference( const four::Algorithm& algo, const ReferencePatch& p,
+                              double* out, int n )
+{
+    four::Phase phase[4] = { 0, 0, 0, 0 };
+    double prev[4] = { 0.0, 0.0, 0.0, 0.0 };
+    for ( int i = 0; i < n; ++i )
+    {
+        double opOut[4] = { 0.0, 0.0, 0.0, 0.0 };
+        for ( int op = 3; op >= 0; --op )
+        {
+            double pm = 0.0;
+            for ( int src = op + 1; src < 4; ++src )
+                if ( algo.mod[src][op] )
+                    pm += opOut[src] * p.level[src] * p.xm;
+            if ( p.feedback[op] > 0.0 )
+                pm += reference_soft_clip( prev[op] * p.feedback[op] );
+
+            float inc = (float)( p.hz * p.ratio[op] / p.sampleRate );
+            four::phase_advance( phase[op], inc );
+            double dt = inc;
+            double ph = phase[op] / 4294967296.0 + pm;
+            ph -= floor( ph );
+
+            double x = p.warp[op] > 0.0 ? reference_warp( ph, p.warp[op], dt, p.polyblep )
+                                        : reference_sine( ph );
+            if ( p.fold[op] > 0.0 )
+                x = reference_fold( x, p.fold[op], p.foldType );
+            opOut[op] = prev[op] = x;
+        }
+
+        out[i] = 0.0;
+        for ( int op = 0; op < 4; ++op )
+            if ( algo.carrier[op] )
+                out[i] += opOut[op] * p.level[op];
+    }
+}
+
+// Render the same patch through the optimized per-algorithm renderer
+inline void render_optimized( int a, const ReferencePatch& p, float* out, int n )
+{
+    static four::BlockScratch s;
+    four::AlgorithmBlock b;
+    four::Phase phase[4] = { 0, 0, 0, 0 };
+    four::FeedbackHistory prev[4] = {};
+    four::AlgorithmRenderer render = four::select_renderer( a, p.polyblep );
+    for ( int done = 0; done < n; done += four::BLOCK_SIZE )
+    {
+        int len = std::min( four::BLOCK_SIZE, n - done );
+        b.n = len;
+        b.xm = s.xm;
+        four::block_fill( s.xm, (float)p.xm, len );
+        for ( int op = 0; op < 4; ++op )
+        {
+            four::block_fill( s.inc[op], (float)( p.hz * p.ratio[op] / p.sampleRate ), len );
+            four::block_fill( s.level[op], (float)p.level[op], len );
+            four::block_fill( s.pm[op], 0.0f, len );
+            b.level[op] = s.level[op];
+            b.pm[op] = s.pm[op];
+
+            four::OperatorBlock& o = b.op[op];
+            o.inc = s.inc[op];
+            o.warp = NULL;
+            o.fold = NULL;
+            o.warpConst = (float)p.warp[op];
+            o.foldConst = (float)p.fold[op];
+            o.feedback = (float)p.feedback[op];
+            o.foldType = (uint8_t)p.foldType;
+            o.warpMode = p.polyblep ? four::WARP_POLYBLEP : four::WARP_NAIVE;
+            o.warpTables = NULL;
+            o.foldHistory = NULL;
+        }
+        render( phase, prev, b, s.opOut, out + done );
+    }
+}
+
+// In-place radix-2 FFT, n a power of two
+inline void fft( std::complex<double>* x, int n )
+{
+    for ( int i = 1, j = 0; i < n; ++i )
+    {
+        int bit = n >> 1;
+        for ( ; j & bit; bit >>= 1 )
+            j ^= bit;
+        j ^= bit;
+        if ( i < j )
+            std::swap( x[i], x[j] );
+    }
+    for ( int len = 2; len <= n; len <<= 1 )
+    {
+        std::complex<double> w = std::polar( 1.0, -2.0 * M_PI / len );
+        for ( int i = 0; i < n; i += len )
+        {
+            std::complex<double> wk = 1.0;
+            for ( int k = 0; k < len / 2; ++k )
+            {
+                std::complex<double> a = x[i + k];
+                std::complex<double> b = x[i + k + len / 2] * wk;
+                x[i + k] = a + b;
+                x[i + k + len / 2] = a - b;
+                wk *= w;
+            }
+        }
+    }
+}
+
+// Hann-windowed magnitude spectrum, bins 0..n/2
+template <typename T>
+inline void magnitude_spectrum( const T* x, int n, double* mag )
+{
+    std::complex<double>* buf = new std::complex<double>[n];
+    for ( int i = 0; i < n; ++i )
+        buf[i] = (double)x[i] * ( 0.5 - 0.5 * cos( 2.0 * M_PI * i / n ) );
+    fft( buf, n );
+    for ( int k = 0; k <= n / 2; ++k )
+        mag[k] = std::abs( buf[k] );
+    delete[] buf;
+}
+
+#endif // FOUR_TESTS_REFERENCE_H
@@ -0,0 +1,1532 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include "../four.cpp"
+
+// Offline host for the full plugin: builds four.cpp against the API stand-in
+// in host/, constructs the algorithm the way the Disting NT does, and runs
+// step(), parameterChanged() and midiMessage() from a script.
+//
+//   render_four SCRIPT OUT.wav   render a script to a 32-bit float WAV
+//   render_four --bench [V]      ns/sample and real-time factor for every
+//                                algorithm, oversampling mode and anti-alias
+//                                setting, with V voices (default 1)
+//   render_four --check          smoke test: every algorithm and oversampling
+//                                mode must produce finite, non-silent output,
+//                                silence skipping must be seamless, programs
+//                                must store, recall and round-trip through
+//                                serialise()/deserialise(), Yamaha voice
+//                                dumps must import, CC bursts must coalesce,
+//                                notes must land on their frame and glides
+//                                must keep their time
+//
+// Script lines (# starts a comment):
+//   spec <name> <value>                 specification, before anything else
+//   <sec> param <name> <value>          raw parameter value, as on the module
+//   <sec> note <note> <velocity>
+//   <sec> off <note>
+//   <sec> cc <cc> <value>
+//   <sec> bend <0-16383>
+//   <sec> program <0-127>               Program Change
+//   <sec> cv <bus> <volts>              hold a bus at a voltage
+//   <sec> ramp <bus> <from> <to> <sec>  linear ramp, then hold
+//   <sec> end                           render length
+// Notes, note offs and bends land on their frame; other events on the
+// step() boundary at or before their time.
+
+static const int kNumBuses = 28;
+static const int kStepFrames = 32;  // frames per step(), a multiple of 4
+
+// --- NT API services ---
+
+_NT_globals NT_globals = { 48000, kStepFrames, NULL, 0 };
+uint8_t NT_screen[128 * 64];
+
+struct Host;
+static Host* host = NULL;
+
+uint32_t NT_algorithmIndex( const _NT_algorithm* ) { return 0; }
+uint32_t NT_parameterOffset( void ) { return 0; }
+void NT_updateParameterDefinition( uint32_t, uint32_t ) {}
+void NT_drawText( int, int, const char*, int, _NT_textAlignment, _NT_textSize ) {}
+int NT_intToString( char* buffer, int32_t value ) { return sprintf( buffer, "%d", (int)value ); }
+int NT_floatToString( char* buffer, float value, int decimalPlaces )
+{
+    return sprintf( buffer, "%.*f", decimalPlaces, value );
+}
+void NT_setParameterFromUi( uint32_t, uint32_t parameter, int16_t value );
+void NT_setParameterFromAudio( uint32_t algorithmIndex, uint32_t parameter, int16_t value )
+{
+    NT_setParameterFromUi( algorithmIndex, parameter, value );
+}
+
+// --- JSON ---
+
+// Just enough JSON for the preset round trip: no escapes, and the reader
+// trusts the member and element counts it reports, so closing brackets
+// are skipped as separators
+
+void _NT_jsonStream::separate()
+{
+    if ( needComma )
+        text += ',';
+    needComma = true;
+}
+
+void _NT_jsonStream::openArray()  { separate(); text += '['; needComma = false; }
+void _NT_jsonStream::closeArray() { text += ']'; needComma = true; }
+void _NT_jsonStream::openObject() { separate(); text += '{'; needComma = false; }
+void _NT_jsonStream::closeObject() { text += '}'; needComma = true; }
+void _NT_jsonStream::addMemberName( const char* name )
+{
+    separate();
+    text += '"';
+    text += name;
+    text += "\":";
+    needComma = false;
+}
+void _NT_jsonStream::addNumber( int value ) { separate(); text += std::to_string( value ); }
+void _NT_jsonStream::addNumber( float value ) { separate(); text += std::to_string( value ); }
+void _NT_jsonStream::addString( const char* str )
+{
+    separate();
+    text += '"';
+    text += str;
+    text += '"';
+}
+void _NT_jsonStream::addBoolean( bool value ) { separate(); text += value ? "true" : "false"; }
+void _NT_jsonStream::addNull() { separate(); text += "null"; }
+
+static const char* skipSeparators( const char* s )
+{
+    while ( *s && strchr( " \t\r\n,:]}", *s ) )
+        ++s;
+    return s;
+}
+
+static const char* skipValue( const char* s )
+{
+    s = skipSeparators( s );
+    int depth = 0;
+    do
+    {
+        if ( *s == '"' )
+        {
+            for ( ++s; *s && *s != '"'; ++s ) {}
+        }
+        else if ( *s == '{' || *s == '[' )
+            ++depth;
+        else if ( *s == '}' || *s == ']' )
+            --depth;
+        else if ( depth == 0 )
+        {
+            while ( *s && !strchr( ",]} \t\r\n", *s ) )
+                ++s;
+            return s;
+        }
+        if ( *s )
+            ++s;
+    } while ( *s && depth > 0 );
+    return s;
+}
+
+bool _NT_jsonParse::open( char bracket, char close, int& num )
+{
+    pos = skipSeparators( pos );
+    if ( *pos != bracket )
+        return false;
+    ++pos;
+    num = 0;
+    const char* s = pos;
+    for ( ;; )
+    {
+        while ( *s && strchr( " \t\r\n,", *s ) )
+            ++s;
+        if ( !*s || *s == close )
+            break;
+        if ( bracket == '{' )
+            s = skipValue( s );  // the name
+        s = skipValue( s );
+        ++num;
+    }
+    return *s == close;
+}
+
+bool _NT_jsonParse::numberOfObjectMembers( int& num ) { return open( '{', '}', num ); }
+bool _NT_jsonParse::numberOfArrayElements( int& num ) { return open( '[', ']', num ); }
+
+bool _NT_jsonParse::matchName( const char* name )
+{
+    pos = skipSeparators( pos );
+    size_t n = strlen( name );
+    if ( *pos != '"' || strncmp( pos + 1, name, n ) != 0 || pos[n + 1] != '"' )
+        return false;
+    pos += n + 2;
+    return true;
+}
+
+bool _NT_jsonParse::skipMember()
+{
+    pos = skipValue( skipValue( pos ) );
+    return true;
+}
+
+bool _NT_jsonParse::number( int& value )
+{
+    float f;
+    if ( !number( f ) )
+        return false;
+    value = (int)f;
+    return true;
+}
+
+bool _NT_jsonParse::number( float& value )
+{
+    pos = skipSeparators( pos );
+    char* end;
+    value = strtof( pos, &end );
+    if ( end == pos )
+        return false;
+    pos = end;
+    return true;
+}
+
+bool _NT_jsonParse::boolean( bool& value )
+{
+    pos = skipSeparators( pos );
+    value = strncmp( pos, "true", 4 ) == 0;
+    if ( !value && strncmp( pos, "false", 5 ) != 0 )
+        return false;
+    pos += value ? 4 : 5;
+    return true;
+}
+
+bool _NT_jsonParse::string( const char*& value )
+{
+    pos = skipSeparators( pos );
+    if ( *pos != '"' )
+        return false;
+    const char* end = strchr( pos + 1, '"' );
+    if ( !end )
+        return false;
+    str.assign( pos + 1, end );
+    pos = end + 1;
+    value = str.c_str();
+    return true;
+}
+
+// --- Host ---
+
+enum EventType { kEvParam, kEvNote, kEvOff, kEvCC, kEvBend, kEvProgram, kEvCV, kEvRamp, kEvEnd };
+
+struct Event
+{
+    double time;
+    EventType type;
+    int a;
+    int b;
+    float x;
+    float y;
+    float z;
+};
+
+struct CVSource
+{
+    float from;
+    float to;
+    int64_t start;
+    int64_t length;  // 0 = hold `to`
+};
+
+// Static memory is the factory's, set up once and shared by every
+// instance, as on the module
+static std::vector<uint8_t> staticDram;
+
+static void initialiseFactory( const _NT_factory* factory )
+{
+    if ( !factory->calculateStaticRequirements || !staticDram.empty() )
+        return;
+    _NT_staticRequirements req = { 0 };
+    factory->calculateStaticRequirements( req );
+    staticDram.assign( req.dram, 0 );
+    _NT_staticMemoryPtrs ptrs = { staticDram.data() };
+    factory->initialise( ptrs, req );
+}
+
+struct Host
+{
+    const _NT_factory* factory;
+    std::vector<int32_t> specs;
+    std::vector<uint8_t> sram;
+    std::vector<uint8_t> dram;
+    std::vector<int16_t> values;
+    _NT_algorithm* alg;
+    float bus[kNumBuses * kStepFrames];
+    CVSource cv[kNumBuses];
+    bool cvActive[kNumBuses];
+    int64_t frame;
+
+    Host() : factory( (const _NT_factory*)pluginEntry( kNT_selector_factoryInfo, 0 ) ), alg( NULL ), frame( 0 )
+    {
+        initialiseFactory( factory );
+        for ( uint32_t i = 0; i < factory->numSpecifications; ++i )
+            specs.push_back( factory->specifications[i].def );
+        for ( int b = 0; b < kNumBuses; ++b )
+            cvActive[b] = false;
+    }
+
+    // Construct with the current specifications, then apply every default
+    // the way the module does after loading an algorithm
+    void create()
+    {
+        _NT_algorithmRequirements req;
+        factory->calculateRequirements( req, specs.data() );
+        sram.assign( req.sram, 0 );
+        dram.assign( req.dram, 0 );
+        _NT_algorithmMemoryPtrs ptrs = { sram.data(), dram.data(), NULL, NULL };
+        alg = factory->construct( ptrs, req, specs.data() );
+        values.resize( req.numParameters );
+        for ( uint32_t p = 0; p < req.numParameters; ++p )
+            values[p] = alg->parameters[p].def;
+        alg->v = alg->vIncludingCommon = values.data();
+        for ( uint32_t p = 0; p < req.numParameters; ++p )
+            factory->parameterChanged( alg, p );
+        frame = 0;
+    }
+
+    void setParameter( int p, int value )
+    {
+        const _NT_parameter& def = alg->parameters[p];
+        values[p] = (int16_t)std::min<int>( def.max, std::max<int>( def.min, value ) );
+        factory->parameterChanged( alg, p );
+    }
+
+    int channel() const { return values[kParamMidiChannel] - 1; }
+
+    void midi( uint8_t b0, uint8_t b1, uint8_t b2 )
+    {
+        factory->midiMessage( alg, b0, b1, b2 );
+    }
+
+    // Notes and bends go straight to the plugin's MIDI queue, stamped
+    // with their frame in the coming step(), as if midiMessage() had
+    // placed them exactly
+    void note( int frame, uint8_t b0, uint8_t b1, uint8_t b2 )
+    {
+        queueMidi( (_fourAlgorithm*)alg, (uint16_t)frame, b0, b1, b2 );
+    }
+
+    void apply( const Event& e, int offset )
+    {
+        float rate = (float)NT_globals.sampleRate;
+        switch ( e.type )
+        {
+        case kEvParam: setParameter( e.a, e.b ); break;
+        case kEvNote:  note( offset, 0x90 | channel(), e.a, e.b ); break;
+        case kEvOff:   note( offset, 0x80 | channel(), e.a, 0 ); break;
+        case kEvCC:    midi( 0xB0 | channel(), e.a, e.b ); break;
+        case kEvBend:  note( offset, 0xE0 | channel(), e.a & 0x7F, ( e.a >> 7 ) & 0x7F ); break;
+        case kEvProgram: midi( 0xC0 | channel(), e.a, 0 ); break;
+        case kEvCV:
+        case kEvRamp:
+            if ( e.a >= 1 && e.a <= kNumBuses )
+            {
+                CVSource& c = cv[e.a - 1];
+                c.from = e.x;
+                c.to = e.type == kEvCV ? e.x : e.y;
+                c.start = frame;
+                c.length = e.type == kEvCV ? 0 : (int64_t)( e.z * rate );
+                cvActive[e.a - 1] = true;
+            }
+            break;
+        case kEvEnd: break;
+        }
+    }
+
+    // Render `frames` output samples in step()-sized chunks into out
+    // (may be NULL), applying each step's events before it: notes and
+    // bends at their frame, everything else at the step's start
+    void render( const std::vector<Event>& events, size_t& next, float* out, int64_t frames )
+    {
+        double rate = (double)NT_globals.sampleRate;
+        int outBus = values[kParamOutput] - 1;
+        for ( int64_t done = 0; done < frames; )
+        {
+            int n = (int)std::min<int64_t>( kStepFrames, frames - done );
+            n = ( n + 3 ) & ~3;
+
+            while ( next < events.size() && events[next].time * rate < (double)( frame + n ) )
+            {
+                int64_t at = (int64_t)( events[next].time * rate );
+                apply( events[next++], (int)std::max<int64_t>( 0, at - frame ) );
+            }
+            memset( bus, 0, sizeof(bus) );
+            for ( int b = 0; b < kNumBuses; ++b )
+            {
+                if ( !cvActive[b] )
+                    continue;
+                const CVSource& c = cv[b];
+                for ( int j = 0; j < n; ++j )
+                {
+                    int64_t t = frame + j - c.start;
+                    bus[b * n + j] = ( c.length > 0 && t < c.length )
+                                     ? c.from + ( c.to - c.from ) * (float)t / (float)c.length
+                                     : c.to;
+                }
+            }
+
+            factory->step( alg, bus, n / 4 );
+
+            int keep = (int)std::min<int64_t>( n, frames - done );
+            if ( out )
+                memcpy( out + done, bus + outBus * n, keep * sizeof(float) );
+            frame += n;
+            done += keep;
+        }
+    }
+};
+
+void NT_setParameterFromUi( uint32_t, uint32_t parameter, int16_t value )
+{
+    if ( host )
+        host->setParameter( parameter, value );
+}
+
+// --- Scripts ---
+
+static int findByName( const char* name, const char* const* names, int count )
+{
+    for ( int i = 0; i < count; ++i )
+        if ( strcasecmp( names[i], name ) == 0 )
+            return i;
+    return -1;
+}
+
+static int findParameter( const char* name )
+{
+    std::vector<const char*> names;
+    for ( int p = 0; p < kNumParams; ++p )
+        names.push_back( parameters[p].name );
+    return findByName( name, names.data(), kNumParams );
+}
+
+static bool parseScript( const char* path, Host& h, std::vector<Event>& events, double& length )
+{
+    FILE* f = fopen( path, "r" );
+    if ( !f )
+    {
+        fprintf( stderr, "can't open %s\n", path );
+        return false;
+    }
+    char line[256];
+    int lineNo = 0;
+    length = 0.0;
+    while ( fgets( line, sizeof(line), f ) )
+    {
+        ++lineNo;
+        char* hash = strchr( line, '#' );
+        if ( hash )
+            *hash = 0;
+        std::vector<std::string> tok;
+        for ( char* t = strtok( line, " \t\r\n" ); t; t = strtok( NULL, " \t\r\n" ) )
+            tok.push_back( t );
+        if ( tok.empty() )
+            continue;
+
+        // Names may contain spaces: everything between the command and the value
+        std::string name;
+        for ( size_t i = 1; i + 1 < tok.size(); ++i )
+            name += ( i > 1 ? " " : "" ) + tok[i];
+
+        if ( tok[0] == "spec" && tok.size() >= 3 )
+        {
+            std::vector<const char*> names;
+            for ( uint32_t i = 0; i < h.factory->numSpecifications; ++i )
+                names.push_back( h.factory->specifications[i].name );
+            int s = findByName( name.c_str(), names.data(), (int)names.size() );
+            if ( s < 0 )
+                goto bad;
+            h.specs[s] = atoi( tok.back().c_str() );
+            continue;
+        }
+
+        {
+            if ( tok.size() < 2 )
+                goto bad;
+            Event e = { atof( tok[0].c_str() ), kEvEnd, 0, 0, 0.0f, 0.0f, 0.0f };
+            const std::string& cmd = tok[1];
+            size_t args = tok.size() - 2;
+            if ( cmd == "param" && args >= 2 )
+            {
+                name = tok[2];
+                for ( size_t i = 3; i + 1 < tok.size(); ++i )
+                    name += " " + tok[i];
+                e.type = kEvParam;
+                e.a = findParameter( name.c_str() );
+                e.b = atoi( tok.back().c_str() );
+                if ( e.a < 0 )
+                    goto bad;
+            }
+            else if ( cmd == "note" && args == 2 )
+            {
+                e.type = kEvNote; e.a = atoi( tok[2].c_str() ); e.b = atoi( tok[3].c_str() );
+            }
+            else if ( cmd == "off" && args == 1 )
+            {
+                e.type = kEvOff; e.a = atoi( tok[2].c_str() );
+            }
+            else if ( cmd == "cc" && args == 2 )
+            {
+                e.type = kEvCC; e.a = atoi( tok[2].c_str() ); e.b = atoi( tok[3].c_str() );
+            }
+            else if ( cmd == "bend" && args == 1 )
+            {
+                e.type = kEvBend; e.a = atoi( tok[2].c_str() );
+            }
+            else if ( cmd == "program" && args == 1 )
+            {
+                e.type = kEvProgram; e.a = atoi( tok[2].c_str() );
+            }
+            else if ( cmd == "cv" && args == 2 )
+            {
+                e.type = kEvCV; e.a = atoi( tok[2].c_str() ); e.x = atof( tok[3].c_str() );
+            }
+            else if ( cmd == "ramp" && args == 4 )
+            {
+                e.type = kEvRamp; e.a = atoi( tok[2].c_str() );
+                e.x = atof( tok[3].c_str() ); e.y = atof( tok[4].c_str() ); e.z = atof( tok[5].c_str() );
+            }
+            else if ( cmd == "end" && args == 0 )
+            {
+                length = std::max( length, e.time );
+            }
+            else
+                goto bad;
+            events.push_back( e );
+            length = std::max( length, e.time );
+            continue;
+        }
+    bad:
+        fprintf( stderr, "%s:%d: can't parse\n", path, lineNo );
+        fclose( f );
+        return false;
+    }
+    fclose( f );
+    std::stable_sort( events.begin(), events.end(),
+                      []( const Event& a, const Event& b ) { return a.time < b.time; } );
+    return true;
+}
+
+// --- WAV ---
+
+static void put16( FILE* f, uint16_t v ) { fputc( v & 0xFF, f ); fputc( v >> 8, f ); }
+static void put32( FILE* f, uint32_t v ) { put16( f, v & 0xFFFF ); put16( f, v >> 16 ); }
+
+// Mono 32-bit float
+static bool writeWav( const char* path, const float* samples, uint32_t count, uint32_t rate )
+{
+    FILE* f = fopen( path, "wb" );
+    if ( !f )
+        return false;
+    uint32_t bytes = count * 4;
+    fwrite( "RIFF", 1, 4, f ); put32( f, 36 + bytes );
+    fwrite( "WAVE", 1, 4, f );
+    fwrite( "fmt ", 1, 4, f ); put32( f, 16 );
+    put16( f, 3 );              // IEEE float
+    put16( f, 1 );              // mono
+    put32( f, rate );
+    put32( f, rate * 4 );
+    put16( f, 4 );
+    put16( f, 32 );
+    fwrite( "data", 1, 4, f ); put32( f, bytes );
+    fwrite( samples, 4, count, f );  // little-endian hosts
+    fclose( f );
+    return true;
+}
+
+// --- Built-in patches ---
+
+static void event( std::vector<Event>& ev, double t, EventType type, int a, int b = 0,
+                   float x = 0.0f, float y = 0.0f, float z = 0.0f )
+{
+    Event e = { t, type, a, b, x, y, z };
+    ev.push_back( e );
+}
+
+// A busy patch: every operator audible, some feedback, warp and fold,
+// a chord per voice, XM swept by CV on bus 2
+static std::vector<Event> busyPatch( int algorithm, int oversample, int antiAlias, int voices )
+{
+    std::vector<Event> ev;
+    event( ev, 0, kEvParam, kParamAlgorithm, algorithm );
+    event( ev, 0, kEvParam, kParamOversampling, oversample );
+    event( ev, 0, kEvParam, kParamAntiAlias, antiAlias );
+    event( ev, 0, kEvParam, kParamXM, 50 );
+    event( ev, 0, kEvParam, kParamXMCV, 2 );
+    event( ev, 0, kEvRamp, 2, 0, -2.0f, 2.0f, 1.0f );
+    for ( int op = 0; op < 4; ++op )
+    {
+        event( ev, 0, kEvParam, opParam( op, kOpCoarse ), 3 + op * 2 );
+        event( ev, 0, kEvParam, opParam( op, kOpLevel ), 80 );
+    }
+    event( ev, 0, kEvParam, kParamOp4Feedback, 30 );
+    event( ev, 0, kEvParam, kParamOp2Warp, 40 );
+    event( ev, 0, kEvParam, kParamOp1Fold, 30 );
+    event( ev, 0, kEvParam, kParamOp1FoldAA, antiAlias == 2 );  // ADAA with the tables
+    static const int chord[8] = { 48, 55, 60, 64, 67, 70, 72, 76 };
+    for ( int v = 0; v < voices; ++v )
+        event( ev, 0, kEvNote, chord[v], 100 );
+    return ev;
+}
+
+// Every rate-selectable CV input on slowly moving buses, read at `cvRate`
+static void slowCVs( std::vector<Event>& ev, int cvRate )
+{
+    event( ev, 0, kEvRamp, 3, 0, 0.0f, 2.0f, 1.0f );
+    event( ev, 0, kEvCV, 4, 0, 4.0f );
+    event( ev, 0, kEvParam, kParamGlobalVCACV, 4 );
+    for ( int op = 0; op < 4; ++op )
+    {
+        event( ev, 0, kEvParam, opLevelCV( op ), 3 );
+        event( ev, 0, kEvParam, opPMCV( op ), 3 );
+        event( ev, 0, kEvParam, opWarpCV( op ), 3 );
+        event( ev, 0, kEvParam, opFoldCV( op ), 3 );
+        event( ev, 0, kEvParam, kParamOp1LevelCVDepth + op, 50 );
+        event( ev, 0, kEvParam, kParamOp1PMCVDepth + op, 20 );
+        event( ev, 0, kEvParam, kParamOp1WarpCVDepth + op, 50 );
+        event( ev, 0, kEvParam, kParamOp1FoldCVDepth + op, 50 );
+    }
+    for ( int i = 0; i < kNumRatedCV; ++i )
+        event( ev, 0, kEvParam, kParamXMCVRate + i, cvRate );
+}
+
+static const char* oversampleName( int o )
+{
+    return oversampleStrings[o];
+}
+
+static Host* makeHost( int voices )
+{
+    Host* h = new Host();
+    h->specs[kSpecVoices] = voices;
+    h->specs[kSpecMaxOversampling] = 3;
+    h->create();
+    host = h;
+    return h;
+}
+
+static int bench( int voices )
+{
+    const double seconds = 1.0;
+    const double rate = NT_globals.sampleRate;
+    int64_t frames = (int64_t)( seconds * rate );
+    int numModes = kOversampleAuto + 1;
+
+    printf( "Four step() benchmark, %d voice%s, %d-frame steps (ns/sample, real-time factor)\n\n",
+            voices, voices > 1 ? "s" : "", kStepFrames );
+    for ( int aa = 0; aa <= four::WARP_TABLE; ++aa )
+    {
+        printf( "Anti-alias %s\n  algo", antiAliasStrings[aa] );
+        for ( int o = 0; o < numModes; ++o )
+            printf( "  %13s", oversampleName( o ) );
+        printf( "\n" );
+        for ( int a = 0; a < 11; ++a )
+        {
+            printf( "  %4d", a + 1 );
+            for ( int o = 0; o < numModes; ++o )
+            {
+                Host* h = makeHost( voices );
+                std::vector<Event> ev = busyPatch( a, o, aa, voices );
+                size_t next = 0;
+                h->render( ev, next, NULL, (int64_t)( 0.1 * rate ) );  // settle
+                std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+                h->render( ev, next, NULL, frames );
+                std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+                double ns = std::chrono::duration<double, std::nano>( t1 - t0 ).count() / frames;
+                printf( "  %6.0f %5.1fx", ns, 1e9 / ( ns * rate ) );
+                delete h;
+            }
+            printf( "\n" );
+        }
+        printf( "\n" );
+    }
+
+    printf( "CV rate, 18 inputs on slow CVs, algorithm 1, 2x, PolyBLEP\n" );
+    for ( int r = kCVRateAudio; r <= kCVRateBlock; ++r )
+    {
+        Host* h = makeHost( voices );
+        std::vector<Event> ev = busyPatch( 0, 1, 1, voices );
+        slowCVs( ev, r );
+        size_t next = 0;
+        h->render( ev, next, NULL, (int64_t)( 0.1 * rate ) );
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        h->render( ev, next, NULL, frames );
+        std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>( t1 - t0 ).count() / frames;
+        printf( "  %-8s %6.0f %5.1fx\n", cvRateStrings[r], ns, 1e9 / ( ns * rate ) );
+        delete h;
+    }
+    host = NULL;
+    return 0;
+}
+
+// Silence skipping: a released chord must settle to exact zeros with the
+// operators skipped, and the phases after a VCA gap must match the same
+// patch rendered with the VCA left open
+static int checkSilence()
+{
+    const double rate = NT_globals.sampleRate;
+    int failures = 0;
+
+    Host* h = makeHost( 4 );
+    std::vector<Event> ev = busyPatch( 0, 1, 1, 4 );
+    static const int chord[4] = { 48, 55, 60, 64 };
+    for ( int v = 0; v < 4; ++v )
+        event( ev, 0.05, kEvOff, chord[v] );
+    size_t next = 0;
+    std::vector<float> out( (size_t)( 0.5 * rate ) );
+    h->render( ev, next, out.data(), out.size() );
+    _fourAlgorithm* p = (_fourAlgorithm*)h->alg;
+    bool zero = true;
+    for ( size_t i = out.size() - 256; i < out.size(); ++i )
+        zero &= out[i] == 0.0f;
+    if ( !p->idle || !zero || p->skippedBlocks == 0 )
+    {
+        printf( "  FAIL released chord did not go idle (%u blocks skipped)\n", p->skippedBlocks );
+        ++failures;
+    }
+    delete h;
+
+    // Skipped blocks keep the phases rendering would have reached, also
+    // on the per-frame pitch path (FM CV patched, or a glide across the
+    // gap, 2x)
+    static const char* const pathName[3] = { "", " with FM CV", " while gliding" };
+    for ( int path = 0; path < 3; ++path )
+    {
+        four::Phase phase[2][4];
+        for ( int gap = 0; gap < 2; ++gap )
+        {
+            h = makeHost( 1 );
+            ev = busyPatch( 2, 1, 1, 1 );
+            event( ev, 0, kEvParam, kParamSmoothing, 0 );
+            if ( path == 1 )
+            {
+                event( ev, 0, kEvParam, kParamFMCV, 3 );
+                event( ev, 0, kEvCV, 3, 0, 0.1f );  // +100 Hz
+            }
+            if ( path == 2 )
+            {
+                event( ev, 0, kEvParam, kParamGlide, 200 );
+                event( ev, 0.05, kEvNote, 72, 100 );
+            }
+            if ( gap )
+            {
+                event( ev, 0.05, kEvParam, kParamGlobalVCA, 0 );
+                event( ev, 0.15, kEvParam, kParamGlobalVCA, 100 );
+            }
+            next = 0;
+            h->render( ev, next, NULL, (int64_t)( 0.2 * rate ) );
+            memcpy( phase[gap], ( (_fourAlgorithm*)h->alg )->voices.phase[0], sizeof(phase[gap]) );
+            delete h;
+        }
+        for ( int op = 0; op < 4; ++op )
+        {
+            // Fixed-point steps add up the same skipped as rendered
+            if ( phase[1][op] != phase[0][op] )
+            {
+                printf( "  FAIL operator %d phase after a VCA gap%s is off by %g\n", op + 1,
+                        pathName[path],
+                        four::phase_to_float( phase[1][op] - phase[0][op] ) );
+                ++failures;
+            }
+        }
+    }
+    host = NULL;
+    return failures;
+}
+
+static bool sameBank( const ProgramBank& a, const ProgramBank& b )
+{
+    for ( int i = 0; i < kNumPrograms; ++i )
+    {
+        if ( a.slot[i].count != b.slot[i].count
+             || memcmp( a.slot[i].value, b.slot[i].value, a.slot[i].count * sizeof(int16_t) ) != 0 )
+            return false;
+    }
+    return true;
+}
+
+// Programs: Store then Program Change must bring the sound back in one
+// go at the next block, host values included, and the bank must survive
+// a preset round trip
+static int checkPrograms()
+{
+    int failures = 0;
+    Host* h = makeHost( 1 );
+    _fourAlgorithm* p = (_fourAlgorithm*)h->alg;
+    std::vector<Event> ev;
+    size_t next = 0;
+    h->setParameter( kParamAlgorithm, 6 );
+    h->setParameter( kParamXM, 12 );
+    h->setParameter( kParamOp2Level, 37 );
+    h->setParameter( kParamOp3FreqMode, 1 );
+    h->setParameter( kParamProgram, 10 );
+    h->setParameter( kParamProgramAction, kProgramActionStore );
+    if ( h->values[kParamProgramAction] != kProgramActionNone || p->programs->slot[9].count == 0 )
+    {
+        printf( "  FAIL Store did not fill program 10\n" );
+        ++failures;
+    }
+
+    // Queued with the CCs: an earlier CC lands first and the program wins
+    h->midi( 0xB0 | h->channel(), 15, 127 );  // XM
+    h->midi( 0xC0 | h->channel(), 0, 0 );     // Init
+    if ( p->algorithm != 6 || h->values[kParamProgram] != 10 )
+    {
+        printf( "  FAIL Program Change recalled before the next block\n" );
+        ++failures;
+    }
+    h->render( ev, next, NULL, kStepFrames );
+    if ( p->algorithm != 0 || h->values[kParamOp2Level] != 100 || h->values[kParamProgram] != 1
+         || h->values[kParamXM] != parameters[kParamXM].def || p->program != 0 )
+    {
+        printf( "  FAIL Program Change 0 did not recall Init\n" );
+        ++failures;
+    }
+    h->midi( 0xC0 | h->channel(), 9, 0 );
+    h->render( ev, next, NULL, kStepFrames );
+    if ( p->algorithm != 6 || h->values[kParamXM] != 12 || h->values[kParamOp2Level] != 37
+         || p->opFreqMode[2] != 1 || fabsf( p->opLevel[1].target - 0.37f ) > 1e-6f
+         || h->values[kParamProgram] != 10 || parameters[kParamOp3Coarse].unit != kNT_unitHz )
+    {
+        printf( "  FAIL Program Change 9 did not recall the stored program\n" );
+        ++failures;
+    }
+    event( ev, 0, kEvNote, 60, 100 );
+    next = 0;
+    float out[kStepFrames];
+    h->render( ev, next, out, kStepFrames );
+
+    _NT_jsonStream json;
+    json.openObject();
+    h->factory->serialise( h->alg, json );
+    json.closeObject();
+    ProgramBank saved = *p->programs;
+    delete h;
+
+    h = makeHost( 1 );
+    p = (_fourAlgorithm*)h->alg;
+    _NT_jsonParse parse( json.text.c_str() );
+    if ( !h->factory->deserialise( h->alg, parse ) || !sameBank( saved, *p->programs ) )
+    {
+        printf( "  FAIL programs did not survive serialise/deserialise\n" );
+        ++failures;
+    }
+
+    // A record from an older version, with fewer values: the rest default
+    _NT_jsonParse older( "{ \"other\": [1, {\"x\": 2}], \"programs\": [ { \"slot\": 3, \"data\": \"0005\" } ] }" );
+    if ( !h->factory->deserialise( h->alg, older ) || p->programs->slot[0].count != 0
+         || p->programs->slot[3].count != 1 )
+    {
+        printf( "  FAIL short program record not loaded\n" );
+        ++failures;
+    }
+    h->setParameter( kParamOp1Level, 20 );
+    h->midi( 0xC0 | h->channel(), 3, 0 );
+    h->render( ev, next, NULL, kStepFrames );
+    if ( h->values[kParamAlgorithm] != 5 || h->values[kParamOp1Level] != 100 )
+    {
+        printf( "  FAIL short program record not recalled with defaults\n" );
+        ++failures;
+    }
+
+    _NT_jsonParse bad( "{ \"programs\": [ { \"slot\": 1, \"data\": \"00g5\" } ] }" );
+    if ( h->factory->deserialise( h->alg, bad ) )
+    {
+        printf( "  FAIL malformed program record accepted\n" );
+        ++failures;
+    }
+    delete h;
+    host = NULL;
+    return failures;
+}
+
+// A Yamaha bulk dump around `data`, with checksum
+static std::vector<uint8_t> yamahaDump( int format, const std::vector<uint8_t>& data )
+{
+    std::vector<uint8_t> msg = { 0xF0, 0x43, 0x00, (uint8_t)format,
+                                 (uint8_t)( data.size() >> 7 ), (uint8_t)( data.size() & 0x7F ) };
+    uint8_t sum = 0;
+    for ( uint8_t b : data )
+    {
+        msg.push_back( b );
+        sum += b;
+    }
+    msg.push_back( ( 128 - ( sum & 0x7F ) ) & 0x7F );
+    msg.push_back( 0xF7 );
+    return msg;
+}
+
+// Delivered in small pieces, as a slow MIDI stream would be
+static void sendSysEx( Host* h, const std::vector<uint8_t>& msg, size_t chunk )
+{
+    for ( size_t i = 0; i < msg.size(); i += chunk )
+        h->factory->midiSysEx( h->alg, msg.data() + i, (uint32_t)std::min( chunk, msg.size() - i ) );
+}
+
+// SysEx import: a 32-voice VMEM bank lands in the programs from the
+// selected one, translated one voice per block even when the host hands
+// over the whole dump in one call; a corrupt one changes nothing, and an
+// ACED + VCED pair becomes the current sound
+static int checkSysEx()
+{
+    int failures = 0;
+    Host* h = makeHost( 1 );
+    _fourAlgorithm* p = (_fourAlgorithm*)h->alg;
+    std::vector<Event> ev;
+    size_t next = 0;
+
+    std::vector<uint8_t> bank( 32 * 128, 0 );
+    for ( int v = 0; v < 32; ++v )
+    {
+        uint8_t* voice = &bank[v * 128];
+        for ( int k = 0; k < 4; ++k )  // operators 4, 2, 3, 1
+        {
+            voice[k * 10 + 7] = k == 3 ? 99 : 91;  // OUT
+            voice[k * 10 + 8] = k == 1 ? 8 : 4;    // op2 at 2.00, others 1.00
+            voice[k * 10 + 9] = 3;                 // no detune
+        }
+        voice[40] = ( 7 << 3 ) | ( v % 8 );        // FBL 7, ALG
+        voice[47] = v % 13;                        // PBR
+    }
+    std::vector<uint8_t> corrupt = yamahaDump( 0x04, bank );
+    corrupt[100] ^= 1;
+    h->setParameter( kParamProgram, 5 );
+    sendSysEx( h, corrupt, 7 );
+    h->render( ev, next, NULL, 32 * kStepFrames );
+    if ( p->programs->slot[20].count != 0 )
+    {
+        printf( "  FAIL corrupt VMEM bank was imported\n" );
+        ++failures;
+    }
+    std::vector<uint8_t> dump = yamahaDump( 0x04, bank );
+    sendSysEx( h, dump, dump.size() );
+    uint32_t waiting = p->sysex->imported.pending();
+    h->render( ev, next, NULL, kStepFrames );
+    if ( waiting != 32 || p->sysex->imported.pending() != 31 )
+    {
+        printf( "  FAIL VMEM bank in one call: %u voices waiting, %u after a block\n",
+                waiting, p->sysex->imported.pending() );
+        ++failures;
+    }
+    h->render( ev, next, NULL, 31 * kStepFrames );
+    for ( int v = 0; v < 32; ++v )
+    {
+        const Program& prog = p->programs->slot[4 + v];
+        int16_t values[kNumParams];
+        for ( int i = 0; i < kNumProgramParams; ++i )
+            values[programParams[i]] = prog.value[i];
+        int fbSlot = v % 8 == 2 ? 2 : 3;  // Yamaha algorithm 3 swaps operators 3 and 4
+        if ( prog.count != kNumProgramParams || values[kParamAlgorithm] != v % 8
+             || values[kParamOp1Level] != 100 || values[kParamOp2Level] != 50
+             || values[kParamOp2Coarse] != 5 || values[kParamOp2Fine] != 0
+             || values[opParam( fbSlot, kOpFeedback )] != 100
+             || values[kParamBendRange] != v % 13 )
+        {
+            printf( "  FAIL VMEM voice %d translated wrongly\n", v + 1 );
+            ++failures;
+            break;
+        }
+    }
+
+    std::vector<uint8_t> aced( 33, 0 );
+    memcpy( aced.data(), "LM  8976AE", 10 );
+    aced[10 + 3 * 5 + 0] = 1;  // op1 fixed
+    aced[10 + 3 * 5 + 1] = 2;  // range
+    aced[10 + 3 * 5 + 2] = 3;  // fine
+    std::vector<uint8_t> vced( 93, 0 );
+    for ( int k = 0; k < 4; ++k )
+    {
+        vced[k * 13 + 10] = 99;
+        vced[k * 13 + 11] = 4;
+        vced[k * 13 + 12] = 3;
+    }
+    vced[52] = 4;  // algorithm 5
+    vced[64] = 7;  // bend range
+    sendSysEx( h, yamahaDump( 0x7E, aced ), 5 );
+    sendSysEx( h, yamahaDump( 0x03, vced ), 5 );
+    h->render( ev, next, NULL, kStepFrames );
+    if ( p->algorithm != 4 || h->values[kParamAlgorithm] != 4
+         || h->values[kParamOp1FreqMode] != 1 || h->values[kParamOp1FixedHz] != ( 16 + 3 ) << 2
+         || h->values[kParamOp2FreqMode] != 0 || h->values[kParamXM] != 100
+         || h->values[kParamBendRange] != 7 || p->bendRange != 7.0f )
+    {
+        printf( "  FAIL VCED voice not applied\n" );
+        ++failures;
+    }
+    delete h;
+    host = NULL;
+    return failures;
+}
+
+// A note lands on its own frame inside a block, not at the block's start
+static bool anyGate( const _fourAlgorithm* p )
+{
+    for ( int v = 0; v < p->numVoices; ++v )
+        if ( p->voices.gate[v] )
+            return true;
+    return false;
+}
+
+static int checkMidiTiming()
+{
+    int failures = 0;
+    Host* h = makeHost( 4 );  // polyphonic: silent until a note
+    double rate = NT_globals.sampleRate;
+    int onset = kStepFrames + 10;
+    std::vector<Event> ev;
+    event( ev, onset / rate, kEvNote, 69, 100 );
+    std::vector<float> out( 4 * kStepFrames );
+    size_t next = 0;
+    h->render( ev, next, out.data(), out.size() );
+    float before = 0.0f, after = 0.0f;
+    for ( int i = 0; i < (int)out.size(); ++i )
+        ( i < onset ? before : after ) = fmaxf( i < onset ? before : after, fabsf( out[i] ) );
+    if ( before != 0.0f || after < 1e-3f )
+    {
+        printf( "  FAIL note at frame %d: %g before, %g after\n", onset, before, after );
+        ++failures;
+    }
+
+    // Through midiMessage(): queued for the next step(), not played at once
+    h->midi( 0x80 | h->channel(), 69, 0 );
+    h->midi( 0xE0 | h->channel(), 0, 0x40 );
+    _fourAlgorithm* p = (_fourAlgorithm*)h->alg;
+    if ( !anyGate( p ) || p->midiEvents.pending() != 2 )
+    {
+        printf( "  FAIL note off played before the next block\n" );
+        ++failures;
+    }
+    h->render( ev, next, NULL, kStepFrames );
+    if ( anyGate( p ) || p->midiEvents.pending() != 0 )
+    {
+        printf( "  FAIL queued note off not played by the next block\n" );
+        ++failures;
+    }
+    delete h;
+    host = NULL;
+    return failures;
+}
+
+// Glide reaches the note in its time along a log-frequency line; Legato
+// skips it after a release. Bend Range scales the wheel.
+static int checkGlide()
+{
+    int failures = 0;
+    double rate = NT_globals.sampleRate;
+    for ( int legato = 0; legato < 2; ++legato )
+    {
+        Host* h = makeHost( 1 );
+        _fourAlgorithm* p = (_fourAlgorithm*)h->alg;
+        std::vector<Event> ev;
+        event( ev, 0, kEvParam, kParamGlide, 100 );
+        event( ev, 0, kEvParam, kParamGlideMode, legato );
+        event( ev, 0, kEvNote, 57, 100 );   // A3, no glide from nothing
+        event( ev, 0.04, kEvOff, 57 );
+        event( ev, 0.05, kEvNote, 69, 100 );
+        size_t next = 0;
+        h->render( ev, next, NULL, (int64_t)( 0.1 * rate ) );
+        float mid = p->voices.frequency[0];
+        float want = legato ? 440.0f : sqrtf( 220.0f * 440.0f );
+        if ( fabsf( mid / want - 1.0f ) > 0.01f )
+        {
+            printf( "  FAIL %s glide halfway at %g Hz, want %g\n", legato ? "legato" : "always", mid, want );
+            ++failures;
+        }
+        h->render( ev, next, NULL, (int64_t)( 0.1 * rate ) );
+        if ( p->voices.frequency[0] != p->voices.glideTo[0] || p->voices.glide[0] != 1.0f
+             || fabsf( p->voices.frequency[0] - 440.0f ) > 0.01f )
+        {
+            printf( "  FAIL glide did not settle on the note (%g Hz)\n", p->voices.frequency[0] );
+            ++failures;
+        }
+        delete h;
+    }
+
+    Host* h = makeHost( 1 );
+    std::vector<Event> ev;
+    event( ev, 0, kEvParam, kParamBendRange, 12 );
+    event( ev, 0, kEvBend, 0 );
+    size_t next = 0;
+    h->render( ev, next, NULL, kStepFrames );
+    float bend = ( (_fourAlgorithm*)h->alg )->pitchBendFactor;
+    if ( fabsf( bend - 0.5f ) > 1e-4f )
+    {
+        printf( "  FAIL full bend down over 12 semitones gives %g\n", bend );
+        ++failures;
+    }
+    delete h;
+    host = NULL;
+    return failures;
+}
+
+// A CV that moves in straight lines sounds the same read at control or
+// block rate as at audio rate
+static int checkCVRate()
+{
+    int failures = 0;
+    double rate = NT_globals.sampleRate;
+    int64_t frames = (int64_t)( 0.25 * rate );
+    std::vector<float> out[3];
+    for ( int r = kCVRateAudio; r <= kCVRateBlock; ++r )
+    {
+        Host* h = makeHost( 4 );
+        std::vector<Event> ev = busyPatch( 0, 1, 1, 4 );
+        event( ev, 0, kEvParam, kParamOp4Feedback, 0 );  // chaotic: magnifies rounding
+        slowCVs( ev, r );
+        out[r].resize( frames );
+        size_t next = 0;
+        h->render( ev, next, out[r].data(), frames );
+        delete h;
+    }
+    for ( int r = kCVRateControl; r <= kCVRateBlock; ++r )
+    {
+        double diff = 0.0, power = 0.0;
+        for ( int64_t i = 0; i < frames; ++i )
+        {
+            double d = out[r][i] - out[kCVRateAudio][i];
+            diff += d * d;
+            power += (double)out[kCVRateAudio][i] * out[kCVRateAudio][i];
+        }
+        double db = 10.0 * log10( diff / power + 1e-30 );
+        printf( "  CV rate %s vs Audio: %.1f dB\n", cvRateStrings[r], db );
+        if ( !( db < -40.0 ) )
+        {
+            printf( "  FAIL %s rate CVs differ from audio rate by %.1f dB\n", cvRateStrings[r], db );
+            ++failures;
+        }
+    }
+
+    // Control reads every kControlFrames output frames at any oversampling
+    // factor. The Global VCA applies at the output rate, so on a plain
+    // sine Control over Audio output is the Control line's gain (give or
+    // take the DC blocker), and must not change with the factor.
+    int64_t jump = (int64_t)( 0.1 * rate ) / kStepFrames * kStepFrames;
+    std::vector<double> gain[2];
+    for ( int f = 0; f < 2; ++f )
+    {
+        int oversample = f ? 3 : 0;  // Off, 8x
+        for ( int r = kCVRateAudio; r <= kCVRateControl; ++r )
+        {
+            Host* h = makeHost( 1 );
+            std::vector<Event> ev;
+            event( ev, 0, kEvParam, kParamAlgorithm, 7 );
+            event( ev, 0, kEvParam, kParamOversampling, oversample );
+            for ( int op = 1; op < 4; ++op )
+                event( ev, 0, kEvParam, opParam( op, kOpLevel ), 0 );
+            event( ev, 0, kEvNote, 69, 100 );
+            event( ev, 0, kEvParam, kParamGlobalVCACV, 4 );
+            event( ev, 0, kEvParam, kParamGlobalVCACVRate, r );
+            event( ev, 0, kEvCV, 4, 0, 2.0f );
+            event( ev, (double)jump / rate, kEvRamp, 4, 0, 2.0f, 4.0f, 10.0 / rate );
+            out[r].resize( jump + 2 * kControlFrames );
+            size_t next = 0;
+            h->render( ev, next, out[r].data(), out[r].size() );
+            delete h;
+        }
+        // NAN near zero crossings, where rounding dominates the ratio
+        for ( int64_t i = jump - kControlFrames; i < (int64_t)out[0].size(); ++i )
+            gain[f].push_back( fabsf( out[kCVRateAudio][i] ) > 0.2f
+                               ? out[kCVRateControl][i] / out[kCVRateAudio][i] : NAN );
+    }
+    double spread = 0.0, lag = 0.0;
+    for ( size_t i = 0; i < gain[0].size(); ++i )
+    {
+        if ( std::isnan( gain[0][i] ) || std::isnan( gain[1][i] ) )
+            continue;
+        spread = fmax( spread, fabs( gain[1][i] - gain[0][i] ) );
+        lag = fmax( lag, fabs( gain[0][i] - 1.0 ) );
+    }
+    if ( spread > 1e-2 || lag < 0.1 )
+    {
+        printf( "  FAIL Control rate line differs between 1x and 8x by %.4f (lag %.2f)\n", spread, lag );
+        ++failures;
+    }
+    host = NULL;
+    return failures;
+}
+
+// FM CV past 0 Hz stops an operator in Clamped mode and runs its phase
+// backwards in Through-Zero mode; FM CV Depth scales it per operator
+static int checkThroughZero()
+{
+    int failures = 0;
+    double rate = NT_globals.sampleRate;
+    for ( int mode = 0; mode < 2; ++mode )
+    {
+        Host* h = makeHost( 1 );
+        _fourAlgorithm* p = (_fourAlgorithm*)h->alg;
+        std::vector<Event> ev;
+        event( ev, 0, kEvParam, kParamOversampling, 0 );
+        event( ev, 0, kEvParam, kParamFMCV, 1 );
+        event( ev, 0, kEvParam, kParamFMMode, mode );
+        event( ev, 0, kEvParam, kParamOp2FMCVDepth, 0 );
+        event( ev, 0, kEvCV, 1, 0, -1.0f );  // -1000 Hz
+        event( ev, 0, kEvNote, 69, 100 );
+        size_t next = 0;
+        h->render( ev, next, NULL, kStepFrames );
+        four::Phase op1 = p->voices.phase[0][0], op2 = p->voices.phase[0][1];
+        h->render( ev, next, NULL, kStepFrames );
+        float moved1 = four::phase_to_float( p->voices.phase[0][0] - op1 );
+        float moved2 = four::phase_to_float( p->voices.phase[0][1] - op2 );
+        moved1 -= floorf( moved1 + 0.5f );
+        moved2 -= floorf( moved2 + 0.5f );
+        float want1 = mode ? ( 440.0f - 1000.0f ) * kStepFrames / (float)rate : 0.0f;
+        float want2 = 440.0f * kStepFrames / (float)rate;
+        if ( fabsf( moved1 - want1 ) > 1e-3f || fabsf( moved2 - want2 ) > 1e-3f )
+        {
+            printf( "  FAIL %s FM: Op1 moved %g (want %g), Op2 %g (want %g)\n", fmModeStrings[mode],
+                    moved1, want1, moved2, want2 );
+            ++failures;
+        }
+        delete h;
+    }
+    host = NULL;
+    return failures;
+}
+
+// A 1 Hz fixed-frequency operator at 4x keeps time over two minutes of
+// rendering: its phase moves by the whole cycles elapsed, where a float
+// accumulator would have lost a good part of a cycle
+static int checkPhaseDrift()
+{
+    int failures = 0;
+    double rate = NT_globals.sampleRate;
+    Host* h = makeHost( 1 );
+    _fourAlgorithm* p = (_fourAlgorithm*)h->alg;
+    std::vector<Event> ev;
+    event( ev, 0, kEvParam, kParamOversampling, 2 );  // 4x
+    event( ev, 0, kEvParam, kParamOp1FreqMode, 1 );
+    event( ev, 0, kEvParam, kParamOp1FixedHz, 1 );
+    event( ev, 0, kEvNote, 69, 100 );
+    size_t next = 0;
+    h->render( ev, next, NULL, kStepFrames );
+    four::Phase start = p->voices.phase[0][0];
+    int64_t frames = (int64_t)( 120.0 * rate );
+    h->render( ev, next, NULL, frames );
+    float drift = four::phase_to_float( p->voices.phase[0][0] - start );
+    drift = fabsf( drift - floorf( drift + 0.5f ) );
+
+    float inc = 1.0f / ( (float)rate * 4.0f ), floatPhase = 0.0f;
+    for ( int64_t i = 0; i < frames * 4; ++i )
+    {
+        floatPhase += inc;
+        floatPhase -= floorf( floatPhase );
+    }
+    float floatDrift = fabsf( floatPhase - floorf( floatPhase + 0.5f ) );
+    printf( "  Phase drift over 120 s at 1 Hz, 4x: %.5f cycles (float accumulator %.3f)\n",
+            drift, floatDrift );
+    if ( !( drift < 0.01f ) )
+    {
+        printf( "  FAIL 1 Hz operator drifted %g cycles in 120 s\n", drift );
+        ++failures;
+    }
+    delete h;
+    host = NULL;
+    return failures;
+}
+
+// Op1 alone at 440 Hz with 55% feedback keeps its harmonics with
+// oversampling off or at 4x in DX Average mode, not in Last Sample
+static int checkFeedbackMode()
+{
+    int failures = 0;
+    double rate = NT_globals.sampleRate;
+    int64_t frames = (int64_t)( 0.3 * rate );
+    int window = (int)( 0.1 * rate );  // a whole number of 440 Hz cycles
+    double worst[2];
+    for ( int mode = 0; mode < 2; ++mode )
+    {
+        double db[2][9];
+        for ( int os = 0; os < 2; ++os )
+        {
+            Host* h = makeHost( 1 );
+            std::vector<Event> ev;
+            event( ev, 0, kEvParam, kParamAlgorithm, 7 );  // additive
+            event( ev, 0, kEvParam, kParamOversampling, os ? 2 : 0 );
+            event( ev, 0, kEvParam, kParamFeedbackMode, mode );
+            event( ev, 0, kEvParam, kParamOp1FreqMode, 1 );
+            event( ev, 0, kEvParam, kParamOp1FixedHz, 440 );
+            event( ev, 0, kEvParam, kParamOp1Feedback, 55 );
+            event( ev, 0, kEvParam, kParamOp2Level, 0 );
+            event( ev, 0, kEvParam, kParamOp3Level, 0 );
+            event( ev, 0, kEvParam, kParamOp4Level, 0 );
+            event( ev, 0, kEvNote, 69, 100 );
+            std::vector<float> out( frames );
+            size_t next = 0;
+            h->render( ev, next, out.data(), frames );
+            delete h;
+            const float* x = out.data() + frames - window;
+            for ( int k = 1; k <= 8; ++k )
+            {
+                double re = 0.0, im = 0.0, w = 2.0 * M_PI * 440.0 * k / rate;
+                for ( int i = 0; i < window; ++i )
+                {
+                    re += x[i] * cos( w * i );
+                    im += x[i] * sin( w * i );
+                }
+                db[os][k] = 20.0 * log10( 2.0 * sqrt( re * re + im * im ) / window + 1e-12 );
+            }
+        }
+        worst[mode] = 0.0;
+        for ( int k = 1; k <= 8; ++k )
+            worst[mode] = fmax( worst[mode], fabs( db[1][k] - db[0][k] ) );
+    }
+    printf( "  Feedback harmonics off vs 4x: Last Sample %.1f dB, DX Average %.1f dB\n",
+            worst[0], worst[1] );
+    if ( !( worst[1] < 2.5 && worst[0] > worst[1] + 3.0 ) )
+    {
+        printf( "  FAIL DX Average feedback should hold its harmonics across oversampling\n" );
+        ++failures;
+    }
+    host = NULL;
+    return failures;
+}
+
+// A Sync CV edge resets the operators set to it at its interpolated
+// position between frames; an operator synced to another restarts with
+// each of its cycles, rendered or skipped
+static int checkSync()
+{
+    int failures = 0;
+    double rate = NT_globals.sampleRate;
+    Host* h = makeHost( 1 );
+    _fourAlgorithm* p = (_fourAlgorithm*)h->alg;
+    std::vector<Event> ev;
+    event( ev, 0, kEvParam, kParamOversampling, 0 );
+    event( ev, 0, kEvParam, kParamSyncCV, 1 );
+    event( ev, 0, kEvParam, kParamOp4Sync, kSyncOff );
+    event( ev, 0, kEvNote, 69, 100 );
+    // 0.25 V then 0.75 V from the second step: 0.5 V is crossed halfway
+    // between its first two frames
+    event( ev, kStepFrames / rate, kEvRamp, 1, 0, 0.25f, 0.75f, 1.0f / (float)rate );
+    size_t next = 0;
+    h->render( ev, next, NULL, kStepFrames );
+    four::Phase op4 = p->voices.phase[0][3];
+    h->render( ev, next, NULL, kStepFrames );
+    float inc = 440.0f / (float)rate;
+    float want = inc * ( kStepFrames - 1.5f );
+    float op1 = four::phase_to_float( p->voices.phase[0][0] );
+    float moved4 = four::phase_to_float( p->voices.phase[0][3] - op4 );
+    if ( fabsf( op1 - want ) > 1e-4f || fabsf( moved4 - inc * kStepFrames ) > 1e-4f )
+    {
+        printf( "  FAIL Sync CV: Op1 at %g (want %g), Op4 moved %g\n", op1, want, moved4 );
+        ++failures;
+    }
+
+    // Op1 at 2.5x follows Op2's cycle, through a silent stretch too
+    ev.clear();
+    next = 0;
+    event( ev, 0, kEvParam, kParamOp1Sync, kSyncOp );
+    event( ev, 0, kEvParam, kParamOp1Coarse, 6 );  // 2.5
+    event( ev, 0.05, kEvParam, kParamGlobalVCA, 0 );
+    for ( int i = 0; i < 2; ++i )
+    {
+        h->render( ev, next, NULL, (int64_t)( 0.04 * rate ) );
+        float op2 = four::phase_to_float( p->voices.phase[0][1] );
+        float expect = 2.5f * op2 - floorf( 2.5f * op2 );
+        float op1 = four::phase_to_float( p->voices.phase[0][0] );
+        float diff = fabsf( op1 - expect );
+        if ( fminf( diff, 1.0f - diff ) > 1e-3f )
+        {
+            printf( "  FAIL Op1 synced to Op2 (%s): at %g, want %g\n", i ? "skipped" : "rendered",
+                    op1, expect );
+            ++failures;
+        }
+    }
+    if ( !p->skippedBlocks )
+    {
+        printf( "  FAIL sync check never skipped a block\n" );
+        ++failures;
+    }
+    delete h;
+    host = NULL;
+    return failures;
+}
+
+// A burst of CCs between two blocks costs one conversion per parameter,
+// applied at the next step(), and the host's value follows
+static int checkParamQueue()
+{
+    int failures = 0;
+    Host* h = makeHost( 1 );
+    _fourAlgorithm* p = (_fourAlgorithm*)h->alg;
+    int16_t before = h->values[kParamXM];
+    float target = p->xm.target;
+    for ( int i = 71; i <= 100; ++i )
+    {
+        h->midi( 0xB0 | h->channel(), 15, i );        // XM
+        h->midi( 0xB0 | h->channel(), 25, 127 - i );  // Op1 Level
+    }
+    if ( h->values[kParamXM] != before || p->xm.target != target )
+    {
+        printf( "  FAIL CC applied before the next block\n" );
+        ++failures;
+    }
+    std::vector<Event> ev;
+    size_t next = 0;
+    h->render( ev, next, NULL, kStepFrames );
+    int16_t xm = h->values[kParamXM];
+    if ( xm != scaleCCToParam( 100, kParamXM ) || fabsf( p->xm.target - xm / 100.0f ) > 1e-6f
+         || h->values[kParamOp1Level] != scaleCCToParam( 27, kParamOp1Level ) )
+    {
+        printf( "  FAIL CC burst did not land on its last values\n" );
+        ++failures;
+    }
+    if ( p->updates.coalesced != 60 - 2 || p->updates.spilled != 0 )
+    {
+        printf( "  FAIL CC burst: %u coalesced, %u spilled\n", p->updates.coalesced, p->updates.spilled );
+        ++failures;
+    }
+
+    // Beyond the queue's capacity a sweep still ends on its last value
+    for ( int i = 0; i < 100; ++i )
+        h->midi( 0xB0 | h->channel(), 15, i );
+    h->render( ev, next, NULL, kStepFrames );
+    xm = h->values[kParamXM];
+    if ( p->updates.spilled != 100 - 64 || xm != scaleCCToParam( 99, kParamXM )
+         || fabsf( p->xm.target - xm / 100.0f ) > 1e-6f )
+    {
+        printf( "  FAIL CC overflow: %u spilled, XM %d\n", p->updates.spilled, xm );
+        ++failures;
+    }
+    delete h;
+    host = NULL;
+    return failures;
+}
+
+// Every instance plays from the one set of warp tables in static DRAM
+static int checkSharedTables()
+{
+    int failures = 0;
+    Host* a = makeHost( 1 );
+    Host* b = makeHost( 4 );
+    const four::WarpTables* t = ( (_fourAlgorithm*)a->alg )->warpTables;
+    if ( !t || t != ( (_fourAlgorithm*)b->alg )->warpTables
+         || a->dram.size() >= sizeof( four::WarpTables ) )
+    {
+        printf( "  FAIL warp tables not shared (%zu bytes of DRAM per instance)\n", a->dram.size() );
+        ++failures;
+    }
+    delete a;
+    delete b;
+    host = NULL;
+    return failures;
+}
+
+static int check()
+{
+    const double rate = NT_globals.sampleRate;
+    int64_t frames = (int64_t)( 0.25 * rate );
+    std::vector<float> out( frames );
+    int failures = 0;
+    for ( int voices = 1; voices <= 4; voices += 3 )
+    {
+        for ( int a = 0; a < 11; ++a )
+        {
+            for ( int o = 0; o <= kOversampleAuto; ++o )
+            {
+                Host* h = makeHost( voices );
+                // PolyBLEP and wavetable warp on alternate runs
+                std::vector<Event> ev = busyPatch( a, o, 1 + ( a + o ) % 2, voices );
+                // Switch factor mid-note to exercise the crossfade
+                event( ev, 0.1, kEvParam, kParamOversampling, ( o + 1 ) % ( kOversampleAuto + 1 ) );
+                size_t next = 0;
+                h->render( ev, next, out.data(), frames );
+                h->factory->draw( h->alg );
+
+                double power = 0.0;
+                bool finite = true;
+                for ( int64_t i = 0; i < frames; ++i )
+                {
+                    finite &= std::isfinite( out[i] ) && fabsf( out[i] ) < 10.0f;
+                    power += (double)out[i] * out[i];
+                }
+                double rms = sqrt( power / frames );
+                if ( !finite || rms < 1e-3 )
+                {
+                    printf( "  FAIL algorithm %d, %s, %d voice%s: %s\n", a + 1, oversampleName( o ),
+                            voices, voices > 1 ? "s" : "", finite ? "silent" : "not finite" );
+                    ++failures;
+                }
+                delete h;
+            }
+        }
+    }
+    host = NULL;
+    failures += checkSilence();
+    failures += checkPrograms();
+    failures += checkSysEx();
+    failures += checkSharedTables();
+    failures += checkParamQueue();
+    failures += checkMidiTiming();
+    failures += checkGlide();
+    failures += checkCVRate();
+    failures += checkThroughZero();
+    failures += checkSync();
+    failures += checkPhaseDrift();
+    failures += checkFeedbackMode();
+    printf( "step() smoke test: %s\n", failures ? "FAILED" : "all algorithms and oversampling modes OK" );
+    return failures ? 1 : 0;
+}
+
+int main( int argc, char** argv )
+{
+    if ( argc >= 2 && strcmp( argv[1], "--bench" ) == 0 )
+        return bench( argc >= 3 ? atoi( argv[2] ) : 1 );
+    if ( argc >= 2 && strcmp( argv[1], "--check" ) == 0 )
+        return check();
+    if ( argc != 3 )
+    {
+        fprintf( stderr, "usage: render_four SCRIPT OUT.wav | --bench [voices] | --check\n" );
+        return 2;
+    }
+
+    Host h;
+    std::vector<Event> events;
+    double length;
+    if ( !parseScript( argv[1], h, events, length ) )
+        return 1;
+    h.create();
+    host = &h;
+
+    int64_t frames = (int64_t)( length * NT_globals.sampleRate );
+    std::vector<float> out( frames );
+    size_t next = 0;
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    h.render( events, next, out.data(), frames );
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    host = NULL;
+
+    if ( !writeWav( argv[2], out.data(), (uint32_t)frames, NT_globals.sampleRate ) )
+    {
+        fprintf( stderr, "can't write %s\n", argv[2] );
+        return 1;
+    }
+    double ns = std::chrono::duration<double, std::nano>( t1 - t0 ).count() / frames;
+    printf( "%s: %.2f s, %.0f ns/sample, %.1fx real time\n", argv[2], length, ns,
+            1e9 / ( ns * NT_globals.sampleRate ) );
+    printf( "CPU meters (ticks/sample): min %d, avg %d, max %d\n",
+            h.values[kParamCpuMin], h.values[kParamCpuAvg], h.values[kParamCpuMax] );
+    _fourAlgorithm* p = (_fourAlgorithm*)h.alg;
+    printf( "Silent blocks skipped: %u\n", p->skippedBlocks );
+    printf( "CC updates coalesced: %u, overflowed: %u\n", p->updates.coalesced, p->updates.spilled );
+    return 0;
+}
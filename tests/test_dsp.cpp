@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
 // Test macros
@@ -31,6 +32,7 @@ static int tests_passed = 0;
     } } while(0)
 
 #include "../dsp.h"
+#include "reference.h"
 
 // --- Tests will be added here as DSP functions are implemented ---
 
@@ -62,18 +64,101 @@ TEST(oscillator_sine_half)
 TEST(phase_advance)
 {
     // Phase advances by freq/sampleRate per sample
-    float phase = 0.0f;
+    four::Phase phase = 0;
     float inc = 440.0f / 48000.0f;
     four::phase_advance( phase, inc );
-    ASSERT_NEAR( phase, inc, 1e-9f );
+    ASSERT_NEAR( four::phase_to_float( phase ), inc, 1e-7f );
 }
 
 TEST(phase_advance_wraps)
 {
-    float phase = 0.999f;
+    four::Phase phase = four::phase_step( 0.999f );
     four::phase_advance( phase, 0.01f );
-    ASSERT( phase >= 0.0f && phase < 1.0f );
-    ASSERT_NEAR( phase, 0.009f, 1e-6f );
+    ASSERT_NEAR( four::phase_to_float( phase ), 0.009f, 1e-6f );
+}
+
+TEST(phase_step_drops_whole_cycles)
+{
+    ASSERT( four::phase_step( 3.0f ) == 0 );
+    ASSERT( four::phase_step( 2.25f ) == four::phase_step( 0.25f ) );
+    ASSERT( four::phase_step( -0.25f ) == four::phase_step( 0.75f ) );
+    ASSERT_NEAR( four::phase_to_float( four::phase_step( 0.5f ) ), 0.5f, 1e-7f );
+    // The top of the range still reads as less than a cycle
+    ASSERT( four::phase_to_float( 0xFFFFFFFFu ) < 1.0f );
+    ASSERT_NEAR( four::phase_sine( four::phase_step( 0.25f ) ), 1.0f, 1e-6f );
+    ASSERT_NEAR( four::phase_sine( four::phase_step( 0.1f ) ),
+                 four::oscillator_sine( 0.1f ), 1e-6f );
+}
+
+TEST(phase_accumulator_holds_pitch_for_minutes)
+{
+    // 1 Hz at 192 kHz for two minutes: the fixed-point phase is off only by
+    // the step's rounding (under half of 2^-32 a sample, < 0.003 cycles
+    // here), while the same sum in float rounds every add near 1
+    float inc = 1.0f / 192000.0f;
+    long n = 192000L * 120 + 48000;
+    four::Phase phase = 0;
+    float floatPhase = 0.0f;
+    for ( long i = 0; i < n; ++i )
+    {
+        four::phase_advance( phase, inc );
+        floatPhase += inc;
+        floatPhase -= floorf( floatPhase );
+    }
+    ASSERT_NEAR( four::phase_to_float( phase ), 0.25f, 3e-3f );
+    ASSERT( fabsf( floatPhase - 0.25f ) > 0.01f );
+}
+
+// --- Sine Table ---
+
+// Worst-case linear interpolation error for the configured table size
+static double sine_table_bound()
+{
+    double n = (double)four::SINE_TABLE_SIZE;
+    return M_PI * M_PI / ( 2.0 * n * n ) + 1e-6;  // + float rounding
+}
+
+TEST(sine_table_error_bound)
+{
+    double maxErr = 0.0;
+    for ( int i = 0; i < 100000; ++i )
+    {
+        float ph = (float)i / 100000.0f;
+        double err = fabs( (double)four::oscillator_sine(ph) - sin( 2.0 * M_PI * (double)ph ) );
+        if ( err > maxErr ) maxErr = err;
+    }
+    ASSERT( maxErr < sine_table_bound() );
+}
+
+TEST(sine_table_thd)
+{
+    // Exactly periodic tone: 7 cycles in 3000 samples, phases rounded to float
+    const int N = 3000, K = 7;
+    double sumSq = 0.0, re = 0.0, im = 0.0;
+    for ( int n = 0; n < N; ++n )
+    {
+        double ph = fmod( (double)n * K / N, 1.0 );
+        double x = four::oscillator_sine( (float)ph );
+        sumSq += x * x;
+        re += x * cos( 2.0 * M_PI * ph );
+        im += x * sin( 2.0 * M_PI * ph );
+    }
+    double fundamental = 2.0 * ( re * re + im * im ) / N;
+    double thdn = 10.0 * log10( ( sumSq - fundamental ) / fundamental );
+    ASSERT( thdn < 20.0 * log10( sine_table_bound() ) );
+}
+
+TEST(fold_uses_table_within_bound)
+{
+    // Folder drive range is ±5
+    double maxErr = 0.0;
+    for ( int i = -5000; i <= 5000; ++i )
+    {
+        float x = (float)i / 1000.0f;
+        double err = fabs( (double)four::fold_symmetric(x) - sin( (double)x * M_PI * 0.5 ) );
+        if ( err > maxErr ) maxErr = err;
+    }
+    ASSERT( maxErr < sine_table_bound() + 1e-6 );
 }
 
 // --- Task 8: Frequency Calculation ---
@@ -116,6 +201,39 @@ TEST(midi_note_to_freq)
     ASSERT_NEAR( four::midi_note_to_freq(60), 261.63f, 0.5f );
 }
 
+TEST(fast_exp2_accuracy)
+{
+    // Across ±10 V of pitch CV: relative error under 0.001 cent
+    double maxRel = 0.0;
+    for ( int i = -10000; i <= 10000; ++i )
+    {
+        float x = (float)i / 1000.0f;
+        double exact = exp2( (double)x );
+        double rel = fabs( (double)four::fast_exp2(x) - exact ) / exact;
+        if ( rel > maxRel ) maxRel = rel;
+    }
+    ASSERT( maxRel < 5e-7 );
+    ASSERT( four::fast_exp2( 0.0f ) == 1.0f );
+    ASSERT( four::fast_exp2( 3.0f ) == 8.0f );
+}
+
+TEST(operator_tuning_ratio_and_fixed)
+{
+    uint8_t mode[4]   = { 0, 1, 0, 1 };
+    float coarse[4]   = { 2.0f, 3.0f, 0.5f, 7.0f };
+    float fixedHz[4]  = { 100.0f, 1000.0f, 100.0f, 50.0f };
+    float fine[4]     = { 1.0f, 1.0f, 1.0f, 2.0f };
+    float scale[4], offset[4];
+    four::calc_operator_tuning( mode, coarse, fixedHz, fine, 1.5f, scale, offset );
+
+    float base = 440.0f;
+    ASSERT_NEAR( base * scale[0] + offset[0], 440.0f * 2.0f * 1.5f, 0.01f );
+    ASSERT_NEAR( base * scale[2] + offset[2], 440.0f * 0.5f * 1.5f, 0.01f );
+    // Fixed operators use Fixed Hz, not Coarse, and ignore base and tuning
+    ASSERT_NEAR( base * scale[1] + offset[1], 1000.0f, 0.01f );
+    ASSERT_NEAR( base * scale[3] + offset[3], 100.0f, 0.01f );
+}
+
 // --- Task 9: Wave Warp ---
 
 TEST(warp_zero_is_passthrough)
@@ -203,26 +321,119 @@ TEST(fold_softclip_stays_bounded)
     }
 }
 
+// Double-precision fold curve for the ADAA checks
+static double fold_curve( double x, int type )
+{
+    double s = sin( x * M_PI * 0.5 );
+    if ( type == 0 || ( type == 1 && x >= 0.0 ) )
+        return s;
+    if ( x < -3.0 ) return -1.0;
+    if ( x >  3.0 ) return  1.0;
+    return x * ( 27.0 + x * x ) / ( 27.0 + 9.0 * x * x );
+}
+
+static float fold_adaa( float x, float x0, int type )
+{
+    switch ( type )
+    {
+    case 0:  return four::fold_symmetric_adaa( x, x0 );
+    case 1:  return four::fold_asymmetric_adaa( x, x0 );
+    default: return four::soft_clip_adaa( x, x0 );
+    }
+}
+
+TEST(fold_adaa_is_segment_mean)
+{
+    // Pairs inside one piece, across zero and across the soft clip knee
+    const float pairs[][2] = {
+        { 0.2f, 0.9f }, { -0.4f, 0.5f }, { 1.5f, 4.2f }, { -4.8f, -2.1f },
+        { -2.5f, 3.5f }, { 2.9f, 3.4f }, { -3.2f, -2.95f }, { 4.5f, -4.9f },
+    };
+    for ( int type = 0; type < 3; ++type )
+    {
+        for ( int p = 0; p < 8; ++p )
+        {
+            double a = pairs[p][0], b = pairs[p][1];
+            const int n = 2000;  // Simpson, the knee at ±3 and 0 are only C1
+            double sum = fold_curve( a, type ) + fold_curve( b, type );
+            for ( int i = 1; i < n; ++i )
+                sum += ( i & 1 ? 4.0 : 2.0 ) * fold_curve( a + ( b - a ) * i / n, type );
+            double mean = sum / ( 3.0 * n );
+            ASSERT_NEAR( fold_adaa( pairs[p][1], pairs[p][0], type ), mean, 2e-4 );
+        }
+    }
+}
+
+TEST(fold_adaa_short_segment_tends_to_fold)
+{
+    // As the segment shrinks the quotient must stay well conditioned and
+    // land on f itself, including a zero-length segment
+    const float steps[] = { 1e-2f, 1e-4f, 1e-6f, 0.0f };
+    for ( int type = 0; type < 3; ++type )
+    {
+        for ( float x = -5.0f; x <= 5.0f; x += 0.37f )
+        {
+            for ( int s = 0; s < 4; ++s )
+            {
+                float y = fold_adaa( x, x - steps[s], type );
+                ASSERT_NEAR( y, fold_curve( x - steps[s] * 0.5, type ), 1e-3 );
+            }
+        }
+        // Straddling the seams
+        ASSERT_NEAR( fold_adaa( 1e-7f, -1e-7f, type ), 0.0f, 1e-5f );
+        ASSERT_NEAR( fold_adaa( 3.0f + 1e-6f, 3.0f - 1e-6f, type ),
+                     fold_curve( 3.0, type ), 1e-3 );
+    }
+}
+
+TEST(fold_adaa_zero_amount_tracks_input)
+{
+    float prev = 0.0f;
+    ASSERT_NEAR( four::wave_fold_adaa( 0.5f, 0.0f, 0, prev ), 0.5f, 1e-6f );
+    ASSERT_NEAR( prev, 0.5f, 1e-6f );
+
+    // Turning fold on picks up from the last input, not from zero
+    float y = four::wave_fold_adaa( 0.5f, 0.25f, 0, prev );
+    ASSERT_NEAR( y, four::fold_symmetric_adaa( 1.0f, 0.5f ), 1e-6f );
+    ASSERT_NEAR( prev, 1.0f, 1e-6f );
+}
+
 // --- Task 11: Self-Feedback ---
 
 TEST(feedback_zero_amount)
 {
     // No feedback → 0 contribution
-    ASSERT_NEAR( four::calc_feedback(0.5f, 0.0f), 0.0f, 1e-6f );
+    four::FeedbackHistory prev = { 0.5f, 0.5f };
+    ASSERT_NEAR( four::calc_feedback( prev, 0.0f, 0.5f ), 0.0f, 1e-6f );
 }
 
 TEST(feedback_full_amount)
 {
     // Full feedback → soft-clipped previous output
-    float result = four::calc_feedback( 0.8f, 1.0f );
+    four::FeedbackHistory prev = { 0.8f, 0.8f };
+    float result = four::calc_feedback( prev, 1.0f, 0.0f );
     ASSERT( result > 0.0f && result <= 1.0f );
 }
 
 TEST(feedback_is_bounded)
 {
     // Even with extreme previous output, feedback stays bounded
-    float result = four::calc_feedback( 10.0f, 1.0f );
+    four::FeedbackHistory prev = { 10.0f, -10.0f };
+    float result = four::calc_feedback( prev, 1.0f, 0.0f );
     ASSERT( result >= -1.0f && result <= 1.0f );
+    ASSERT( four::soft_clip( -10.0f ) == -1.0f );
+}
+
+TEST(feedback_averages_last_two_outputs)
+{
+    four::FeedbackHistory prev = { 0.0f, 0.0f };
+    prev.push( 0.2f );
+    prev.push( 0.6f );
+    ASSERT_NEAR( four::calc_feedback( prev, 1.0f, 0.0f ), four::soft_clip( 0.6f ), 1e-6f );
+    ASSERT_NEAR( four::calc_feedback( prev, 1.0f, 0.5f ), four::soft_clip( 0.4f ), 1e-6f );
+    // An alternating output, the unstable mode, averages out
+    prev.push( -0.6f );
+    ASSERT_NEAR( four::calc_feedback( prev, 1.0f, 0.5f ), 0.0f, 1e-6f );
 }
 
 // --- Task 12: Algorithm Routing ---
@@ -335,15 +546,248 @@ TEST(algorithm_11_three_to_one)
     ASSERT( !a.carrier[3] );
 }
 
-// --- Task 16: 2x Oversampling ---
+// --- 2x Oversampling: half-band decimation ---
+
+// Swept FM tone at factor × 48 kHz: carrier sweeps f0 → f1 with a 500 Hz
+// modulator at index 3, so the sidebands stay within ±2 kHz. Runs it
+// through the decimation cascade in blocks and returns output/input RMS
+// in dB, skipping the filters' settling time.
+static double decimate_swept_fm( int factor, int quality, double f0, double f1 )
+{
+    const double rate = 48000.0 * factor;
+    const int frames = 8192;
+    const int skip = 64;
+    const int blockFrames = four::BLOCK_SIZE / factor;
+    four::Decimator4x s4;
+    four::Decimator8x s8;
+    four::DecimatorChain chain;
+    chain.s4 = &s4;
+    chain.s8 = &s8;
+    float buf[four::BLOCK_SIZE];
+    double carrier = 0.0, inPower = 0.0, outPower = 0.0;
+    int n = 0;
+    for ( int b = 0; b < frames / blockFrames; ++b )
+    {
+        for ( int i = 0; i < four::BLOCK_SIZE; ++i, ++n )
+        {
+            double f = f0 + ( f1 - f0 ) * n / ( (double)frames * factor );
+            carrier += f / rate;
+            double x = sin( 2.0 * M_PI * carrier
+                            + 3.0 * sin( 2.0 * M_PI * 500.0 * n / rate ) );
+            buf[i] = (float)x;
+            if ( n >= skip * factor )
+                inPower += x * x / factor;
+        }
+        chain.process( buf, blockFrames, factor, quality );
+        for ( int j = 0; j < blockFrames; ++j )
+            if ( b * blockFrames + j >= skip )
+                outPower += (double)buf[j] * buf[j];
+    }
+    return 10.0 * log10( outPower / inPower + 1e-30 );
+}
+
+TEST(decimator_iir_stopband)
+{
+    // Everything from 28 kHz up would alias below 20 kHz; stage designs
+    // are 87-103 dB
+    ASSERT( decimate_swept_fm( 2, four::DECIMATE_IIR, 30000.0, 46000.0 ) < -90.0 );
+    ASSERT( decimate_swept_fm( 4, four::DECIMATE_IIR, 30000.0, 94000.0 ) < -90.0 );
+    ASSERT( decimate_swept_fm( 8, four::DECIMATE_IIR, 30000.0, 190000.0 ) < -90.0 );
+}
+
+TEST(decimator_fir_stopband)
+{
+    // Stage designs are 71-80 dB
+    ASSERT( decimate_swept_fm( 2, four::DECIMATE_FIR, 30000.0, 46000.0 ) < -75.0 );
+    ASSERT( decimate_swept_fm( 4, four::DECIMATE_FIR, 30000.0, 94000.0 ) < -75.0 );
+    ASSERT( decimate_swept_fm( 8, four::DECIMATE_FIR, 30000.0, 190000.0 ) < -75.0 );
+}
+
+TEST(decimator_passband)
+{
+    for ( int factor = 2; factor <= 8; factor *= 2 )
+    {
+        ASSERT( fabs( decimate_swept_fm( factor, four::DECIMATE_IIR, 100.0, 18000.0 ) ) < 0.01 );
+        ASSERT( fabs( decimate_swept_fm( factor, four::DECIMATE_FIR, 100.0, 18000.0 ) ) < 0.01 );
+    }
+}
+
+TEST(decimator_fir_is_linear_phase)
+{
+    // Impulse response is symmetric about the centre tap
+    four::HalfbandFIR<16> fir( four::halfband2xFIR ), fir2( four::halfband2xFIR );
+    float even[64] = {}, odd[64] = {}, out[32], out2[32];
+    even[0] = 1.0f;
+    odd[1] = 1.0f;
+    fir.process( even, out, 32 );
+    fir2.process( odd, out2, 32 );
+    // Even impulse hits only the centre tap, 15 outputs later
+    for ( int j = 0; j < 32; ++j )
+        ASSERT_NEAR( out[j], j == 15 ? 0.5f : 0.0f, 1e-7f );
+    // Odd impulse traces the taps, mirrored around output 15.5
+    for ( int j = 0; j < 16; ++j )
+        ASSERT_NEAR( out2[j], out2[31 - j], 1e-7f );
+    float sum = 0.0f;
+    for ( int j = 0; j < 32; ++j )
+        sum += out[j] + out2[j];
+    ASSERT_NEAR( sum, 1.0f, 1e-5f );
+}
+
+// --- Adaptive oversampling ---
 
-TEST(downsample_2x)
+static void quiet_patch( four::OperatorRisk op[4], float hz )
 {
-    // Simple half-band filter: average of two samples
-    float s0 = 0.8f;
-    float s1 = 0.6f;
-    float result = four::downsample_2x( s0, s1 );
-    ASSERT_NEAR( result, 0.7f, 1e-6f );
+    for ( int i = 0; i < 4; ++i )
+    {
+        op[i].freq = hz;
+        op[i].level = 0.8f;
+        op[i].feedback = 0.0f;
+        op[i].warp = 0.0f;
+        op[i].fold = 0.0f;
+        op[i].foldType = 0;
+    }
+}
+
+TEST(auto_oversampling_pure_sines_stay_at_1x)
+{
+    // Algorithm 8 is additive: the bandwidth is just the highest operator
+    four::OperatorRisk op[4];
+    quiet_patch( op, 100.0f );
+    op[3].freq = 400.0f;
+    float bw = four::estimate_bandwidth( four::algorithms[7], op, 1.0f, false );
+    ASSERT_NEAR( bw, 400.0f, 1e-3f );
+    ASSERT( four::choose_oversampling( bw, 48000.0f, 8 ) == 1 );
+}
+
+TEST(auto_oversampling_follows_modulation)
+{
+    // 4→3→2→1 at 1 kHz: XM widens the carrier's spectrum
+    four::OperatorRisk op[4];
+    quiet_patch( op, 1000.0f );
+    float none = four::estimate_bandwidth( four::algorithms[0], op, 0.0f, false );
+    float some = four::estimate_bandwidth( four::algorithms[0], op, 0.3f, false );
+    float full = four::estimate_bandwidth( four::algorithms[0], op, 1.0f, false );
+    ASSERT_NEAR( none, 1000.0f, 1e-2f );
+    ASSERT( some > none );
+    ASSERT( full > some );
+    ASSERT( four::choose_oversampling( none, 48000.0f, 8 ) == 1 );
+    ASSERT( four::choose_oversampling( full, 48000.0f, 8 ) == 8 );
+    // Capped at the allocated maximum
+    ASSERT( four::choose_oversampling( full, 48000.0f, 2 ) == 2 );
+}
+
+TEST(auto_oversampling_shaping_raises_risk)
+{
+    four::OperatorRisk op[4];
+    quiet_patch( op, 2000.0f );
+    float plain = four::estimate_bandwidth( four::algorithms[7], op, 0.0f, false );
+    op[0].fold = 1.0f;
+    float folded = four::estimate_bandwidth( four::algorithms[7], op, 0.0f, false );
+    op[0].fold = 0.0f;
+    op[0].warp = 1.0f;
+    float warped = four::estimate_bandwidth( four::algorithms[7], op, 0.0f, false );
+    float blep = four::estimate_bandwidth( four::algorithms[7], op, 0.0f, four::WARP_POLYBLEP );
+    float table = four::estimate_bandwidth( four::algorithms[7], op, 0.0f, four::WARP_TABLE );
+    op[0].warp = 0.0f;
+    op[0].feedback = 0.5f;
+    float fed = four::estimate_bandwidth( four::algorithms[7], op, 0.0f, false );
+    ASSERT( folded > plain );
+    ASSERT( warped > blep );
+    ASSERT( blep > table );
+    ASSERT( table > plain );
+    ASSERT( fed > plain );
+    // Silent carriers don't count
+    op[0].level = 0.0f;
+    op[0].feedback = 0.0f;
+    ASSERT( four::estimate_bandwidth( four::algorithms[7], op, 0.0f, false ) <= plain );
+}
+
+// Energy below 20 kHz off the harmonic bins of a ~550 Hz operator with
+// self-feedback, rendered at factor × 48 kHz and decimated, relative to
+// total
+static double feedback_alias_db( float feedback, float average, int factor )
+{
+    const int n = 4096;
+    const int bin = 47;  // coprime with n, so aliases miss the harmonic bins
+    const int frames = four::BLOCK_SIZE / factor;
+    static float out[n];
+    float inc[four::BLOCK_SIZE], pm[four::BLOCK_SIZE], buf[four::BLOCK_SIZE];
+    four::block_fill( inc, (float)bin / ( (float)n * factor ), four::BLOCK_SIZE );
+    four::block_fill( pm, 0.0f, four::BLOCK_SIZE );
+    four::OperatorBlock o;
+    o.inc = inc;
+    o.warp = NULL;
+    o.fold = NULL;
+    o.warpConst = 0.0f;
+    o.foldConst = 0.0f;
+    o.feedback = feedback;
+    o.feedbackAverage = average;
+    o.foldType = 0;
+    o.warpMode = four::WARP_NAIVE;
+    o.warpTables = NULL;
+    o.foldHistory = NULL;
+    four::Decimator4x s4;
+    four::Decimator8x s8;
+    four::DecimatorChain chain;
+    chain.s4 = &s4;
+    chain.s8 = &s8;
+    four::Phase phase = 0;
+    four::FeedbackHistory prev = {};
+    for ( int done = -n; done < n; done += frames )  // the first n settle
+    {
+        four::render_operator_block( phase, prev, o, pm, buf, four::BLOCK_SIZE );
+        chain.process( buf, frames, factor, four::DECIMATE_IIR );
+        if ( done >= 0 )
+            memcpy( out + done, buf, frames * sizeof(float) );
+    }
+
+    static double mag[n / 2 + 1];
+    magnitude_spectrum( out, n, mag );
+    double power = 0.0, alias = 0.0;
+    for ( int k = 1; k <= n / 2; ++k )
+    {
+        double e = mag[k] * mag[k];
+        power += e;
+        int off = k % bin;
+        if ( k < n * 20000 / 48000 && off > 2 && off < bin - 2 )
+            alias += e;
+    }
+    return 10.0 * log10( alias / power + 1e-30 );
+}
+
+TEST(auto_oversampling_keeps_feedback_clean)
+{
+    // Heavy feedback on a ~550 Hz carrier: whichever feedback mode, the
+    // factor Auto picks must alias within a few dB of fixed 2x
+    static const float amounts[3] = { 0.2f, 0.3f, 0.45f };
+    for ( int a = 0; a < 3; ++a )
+    {
+        four::OperatorRisk op[4];
+        quiet_patch( op, 48000.0f * 47 / 4096 );
+        op[0].feedback = amounts[a];
+        float bw = four::estimate_bandwidth( four::algorithms[7], op, 0.0f, false );
+        int factor = four::choose_oversampling( bw, 48000.0f, 8 );
+        for ( int m = 0; m < 2; ++m )
+        {
+            float average = m * 0.5f;
+            double chosen = feedback_alias_db( amounts[a], average, factor );
+            double fixed2x = feedback_alias_db( amounts[a], average, 2 );
+            printf( "(%.2f %s: %dx %.1f dB, 2x %.1f dB) ", amounts[a], m ? "DX" : "last",
+                    factor, chosen, fixed2x );
+            ASSERT( chosen < fixed2x + 3.0 );
+        }
+    }
+}
+
+TEST(choose_oversampling_thresholds)
+{
+    // Aliases of a spectrum reaching f land at factor × rate − f
+    ASSERT( four::choose_oversampling( 27000.0f, 48000.0f, 8 ) == 1 );
+    ASSERT( four::choose_oversampling( 29000.0f, 48000.0f, 8 ) == 2 );
+    ASSERT( four::choose_oversampling( 75000.0f, 48000.0f, 8 ) == 2 );
+    ASSERT( four::choose_oversampling( 77000.0f, 48000.0f, 8 ) == 4 );
+    ASSERT( four::choose_oversampling( 1e6f, 48000.0f, 8 ) == 8 );
+    ASSERT( four::choose_oversampling( 1e6f, 48000.0f, 1 ) == 1 );
 }
 
 // --- Task 17: PolyBLEP Anti-Aliasing ---
@@ -379,10 +823,857 @@ TEST(polyblep_saw_reduces_aliasing)
     ASSERT( fabsf(blep_transition) < fabsf(raw_transition) );
 }
 
+// --- Band-limited Warp Tables ---
+
+TEST(warp_tables_match_fourier_series)
+{
+    const four::WarpTables& t = warp_tables();
+    // One partial: pure sines at the series' first coefficients
+    const float* top = t.shape[four::WARP_TABLE_LEVELS - 1][0];
+    int quarter = four::WARP_TABLE_SIZE / 4;
+    ASSERT_NEAR( top[quarter], 8.0f / ( 3.14159265f * 3.14159265f ), 1e-6f );
+    ASSERT_NEAR( top[four::WARP_TABLE_STRIDE + quarter], -2.0f / 3.14159265f, 1e-6f );
+    ASSERT_NEAR( top[2 * four::WARP_TABLE_STRIDE + quarter], 4.0f / 3.14159265f, 1e-6f );
+
+    // 512 partials: close to the naive shapes away from their edges
+    const float* rich = t.shape[0][0];
+    for ( int i = 64; i < four::WARP_TABLE_SIZE / 2 - 64; i += 37 )
+    {
+        float phase = (float)i / four::WARP_TABLE_SIZE;
+        ASSERT_NEAR( rich[i], four::waveform_triangle( phase ), 2e-3f );
+        ASSERT_NEAR( rich[four::WARP_TABLE_STRIDE + i], four::waveform_saw( phase ), 1e-2f );
+        ASSERT_NEAR( rich[2 * four::WARP_TABLE_STRIDE + i], four::waveform_pulse( phase ), 2e-2f );
+    }
+    // Guard point repeats the start
+    ASSERT_NEAR( rich[four::WARP_TABLE_SIZE], rich[0], 1e-5f );
+}
+
+TEST(warp_table_level_stays_below_nyquist)
+{
+    ASSERT( four::warp_table_level( 0.0f ) == 0 );
+    ASSERT( four::warp_table_level( 0.49f ) == four::WARP_TABLE_LEVELS - 1 );
+    for ( float inc = 1e-4f; inc < 0.5f; inc *= 1.07f )
+    {
+        int level = four::warp_table_level( inc );
+        ASSERT( four::warp_table_partials( level ) * inc <= 0.5f );
+        // ...and the next richer step of the half-octave series would not
+        if ( level > 0 )
+            ASSERT( 512.0f * powf( 2.0f, -0.5f * ( level - 1 ) ) * inc > 0.499f );
+    }
+}
+
+// Energy off the harmonic bins of a shaped operator, relative to total
+static double shape_alias_db( int warpMode, float warp, int foldType, float fold, bool foldAA,
+                              float direction = 1.0f )
+{
+    const int n = 8192;
+    const int bin = 301;  // coprime with n, so aliases miss the harmonic bins
+    static float out[n];
+    float inc[four::BLOCK_SIZE], pm[four::BLOCK_SIZE];
+    four::block_fill( inc, direction * bin / n, four::BLOCK_SIZE );
+    four::block_fill( pm, 0.0f, four::BLOCK_SIZE );
+    float foldHistory = 0.0f;
+    four::OperatorBlock o;
+    o.inc = inc;
+    o.warp = NULL;
+    o.fold = NULL;
+    o.warpConst = warp;
+    o.foldConst = fold;
+    o.feedback = 0.0f;
+    o.foldType = (uint8_t)foldType;
+    o.warpMode = (uint8_t)warpMode;
+    o.warpTables = &warp_tables();
+    o.foldHistory = foldAA ? &foldHistory : NULL;
+    four::Phase phase = 0;
+    four::FeedbackHistory prev = {};
+    for ( int i = 0; i < n; i += four::BLOCK_SIZE )
+        four::render_operator_block( phase, prev, o, pm, out + i, four::BLOCK_SIZE );
+
+    static double mag[n / 2 + 1];
+    magnitude_spectrum( out, n, mag );
+    double power = 0.0, alias = 0.0;
+    for ( int k = 1; k <= n / 2; ++k )
+    {
+        double e = mag[k] * mag[k];
+        power += e;
+        int off = k % bin;
+        if ( off > 2 && off < bin - 2 )  // outside the Hann main lobe
+            alias += e;
+    }
+    return 10.0 * log10( alias / power );
+}
+
+static double warp_alias_db( int warpMode, float warp )
+{
+    return shape_alias_db( warpMode, warp, 0, 0.0f, false );
+}
+
+TEST(wavetable_warp_aliases_less_than_polyblep)
+{
+    // ~1.76 kHz at 48 kHz, one warp in each segment of the morph:
+    // BLEP leaves the triangle and its polynomial residue, the tables
+    // leave only interpolation error
+    for ( int w = 0; w < 3; ++w )
+    {
+        float warp = 0.3f + 0.35f * w;
+        double naive = warp_alias_db( four::WARP_NAIVE, warp );
+        double blep = warp_alias_db( four::WARP_POLYBLEP, warp );
+        double table = warp_alias_db( four::WARP_TABLE, warp );
+        ASSERT( blep <= naive );  // same below 1/3: BLEP skips the triangle
+        ASSERT( table < blep - 40.0 );
+        ASSERT( table < -90.0 );
+    }
+}
+
+TEST(reversed_operator_aliases_like_forward)
+{
+    // A negative increment plays the waveform backwards: the same
+    // spectrum, so each anti-aliasing mode must do as well as forwards
+    for ( int mode = four::WARP_NAIVE; mode <= four::WARP_TABLE; ++mode )
+    {
+        for ( int w = 0; w < 2; ++w )
+        {
+            float warp = 0.6f + 0.35f * w;  // saw, then pulse
+            double fwd = shape_alias_db( mode, warp, 0, 0.0f, false );
+            double rev = shape_alias_db( mode, warp, 0, 0.0f, false, -1.0f );
+            ASSERT( fabs( rev - fwd ) < 1.0 );
+        }
+    }
+}
+
+TEST(phase_advance_runs_backwards)
+{
+    four::Phase phase = four::phase_step( 0.05f );
+    for ( int i = 0; i < 3; ++i )
+        four::phase_advance( phase, -0.02f );
+    ASSERT_NEAR( four::phase_to_float( phase ), 0.99f, 1e-5f );
+}
+
+TEST(sync_phase_advance_resets_and_reports_wraps)
+{
+    four::Phase phase = four::phase_step( 0.5f );
+    ASSERT( four::sync_phase_advance( phase, 0.1f, -1.0f ) < 0.0f );
+    ASSERT_NEAR( four::phase_to_float( phase ), 0.6f, 1e-6f );
+
+    // Reset a quarter of the way from the end: a quarter increment on
+    float after = four::sync_phase_advance( phase, 0.1f, 0.25f );
+    ASSERT_NEAR( four::phase_to_float( phase ), 0.025f, 1e-6f );
+    ASSERT_NEAR( after, 0.25f, 1e-6f );
+
+    // Wrapping forwards at 0.98 + 0.04 leaves half the sample after it
+    phase = four::phase_step( 0.98f );
+    ASSERT_NEAR( four::sync_phase_advance( phase, 0.04f, -1.0f ), 0.5f, 1e-4f );
+    // ...and backwards through zero the same
+    phase = four::phase_step( 0.02f );
+    ASSERT_NEAR( four::sync_phase_advance( phase, -0.04f, -1.0f ), 0.5f, 1e-4f );
+    ASSERT_NEAR( four::phase_to_float( phase ), 0.98f, 1e-6f );
+}
+
+TEST(sync_edges_land_between_frames)
+{
+    const float cv[6] = { 0.0f, 1.0f, 1.0f, 0.25f, 0.75f, 0.0f };
+    float edges[6], prev = 0.0f;
+    ASSERT( four::sync_edges( edges, cv, prev, 6, 0.5f ) == 2 );
+    ASSERT_NEAR( edges[1], 0.5f, 1e-6f );
+    ASSERT_NEAR( edges[4], 0.5f, 1e-6f );
+    ASSERT( edges[0] < 0.0f && edges[2] < 0.0f && edges[3] < 0.0f && edges[5] < 0.0f );
+    ASSERT( prev == 0.0f );
+
+    // At 4x the crossing halfway through frame 1 falls in its third
+    // sub-sample, with half of that to go
+    float resets[24];
+    four::block_from_sync_edges( resets, edges, 6, 4 );
+    ASSERT_NEAR( resets[4 + 2], 1.0f, 1e-6f );
+    for ( int i = 0; i < 24; ++i )
+        if ( i != 6 && i != 18 )
+            ASSERT( resets[i] < 0.0f );
+    edges[1] = 0.3f;
+    four::block_from_sync_edges( resets, edges, 6, 4 );
+    ASSERT_NEAR( resets[5], 0.8f, 1e-5f );
+}
+
+// Energy off the harmonic bins of a sine hard-synced to a master at bin
+// 301 of 8192, band-limited by render_operator_block or reset naively
+static double sync_alias_db( bool blep )
+{
+    const int n = 8192;
+    const int bin = 301;
+    static float out[n];
+    float inc[four::BLOCK_SIZE], pm[four::BLOCK_SIZE], sync[four::BLOCK_SIZE];
+    four::block_fill( inc, 2.37f * bin / n, four::BLOCK_SIZE );
+    four::block_fill( pm, 0.0f, four::BLOCK_SIZE );
+    four::OperatorBlock o;
+    o.inc = inc;
+    o.warp = NULL;
+    o.fold = NULL;
+    o.warpConst = 0.0f;
+    o.foldConst = 0.0f;
+    o.feedback = 0.0f;
+    o.foldType = 0;
+    o.warpMode = four::WARP_POLYBLEP;
+    o.warpTables = NULL;
+    o.foldHistory = NULL;
+    o.sync = sync;
+    four::Phase master = 0, phase = 0;
+    four::FeedbackHistory prev = {};
+    for ( int i = 0; i < n; i += four::BLOCK_SIZE )
+    {
+        for ( int j = 0; j < four::BLOCK_SIZE; ++j )
+            sync[j] = four::sync_phase_advance( master, (float)bin / n, -1.0f );
+        if ( blep )
+            four::render_operator_block( phase, prev, o, pm, out + i, four::BLOCK_SIZE );
+        else
+        {
+            for ( int j = 0; j < four::BLOCK_SIZE; ++j )
+            {
+                four::sync_phase_advance( phase, inc[j], sync[j] );
+                out[i + j] = four::phase_sine( phase );
+            }
+        }
+    }
+
+    static double mag[n / 2 + 1];
+    magnitude_spectrum( out, n, mag );
+    double power = 0.0, alias = 0.0;
+    for ( int k = 1; k <= n / 2; ++k )
+    {
+        double e = mag[k] * mag[k];
+        power += e;
+        int off = k % bin;
+        if ( off > 2 && off < bin - 2 )
+            alias += e;
+    }
+    return 10.0 * log10( alias / power );
+}
+
+TEST(hard_sync_blep_aliases_less_than_naive_reset)
+{
+    double naive = sync_alias_db( false );
+    double blep = sync_alias_db( true );
+    printf( "(naive %.1f dB, BLEP %.1f dB) ", naive, blep );
+    ASSERT( blep < naive - 6.0 );
+}
+
+// With feedback, the BLEP-corrected sample before a sync edge is what the
+// history carries on, not the value first rendered
+TEST(hard_sync_feedback_history_follows_blep)
+{
+    float inc[four::BLOCK_SIZE], pm[four::BLOCK_SIZE], sync[four::BLOCK_SIZE];
+    float out[four::BLOCK_SIZE];
+    four::block_fill( inc, 0.013f, four::BLOCK_SIZE );
+    four::block_fill( pm, 0.0f, four::BLOCK_SIZE );
+    four::block_fill( sync, -1.0f, four::BLOCK_SIZE );
+    sync[four::BLOCK_SIZE - 1] = 0.5f;  // the edge corrects out[n - 2]
+    four::OperatorBlock o;
+    o.inc = inc;
+    o.warp = NULL;
+    o.fold = NULL;
+    o.warpConst = 0.0f;
+    o.foldConst = 0.0f;
+    o.feedback = 0.3f;
+    o.feedbackAverage = 0.5f;
+    o.foldType = 0;
+    o.warpMode = four::WARP_NAIVE;
+    o.warpTables = NULL;
+    o.foldHistory = NULL;
+    o.sync = sync;
+    four::Phase phase = 0x30000000u;
+    four::FeedbackHistory prev = {};
+    four::render_operator_block( phase, prev, o, pm, out, four::BLOCK_SIZE );
+    ASSERT( prev.last == out[four::BLOCK_SIZE - 1] );
+    ASSERT( prev.prior == out[four::BLOCK_SIZE - 2] );
+}
+
+// Worst difference, over the first 8 harmonics, between a sine with 55%
+// self-feedback rendered at 1x and at 4x. The sine sits at bin 37 of 4096
+// output samples; levels are taken per output sample so rates compare.
+static double feedback_rate_difference_db( float average )
+{
+    const int n = 4096;
+    const int bin = 37;
+    double db[2][9];
+    for ( int r = 0; r < 2; ++r )
+    {
+        int rate = r ? 4 : 1;
+        int len = n * rate;
+        static float out[n * 4];
+        float inc[four::BLOCK_SIZE], pm[four::BLOCK_SIZE];
+        four::block_fill( inc, (float)bin / (float)len, four::BLOCK_SIZE );
+        four::block_fill( pm, 0.0f, four::BLOCK_SIZE );
+        four::OperatorBlock o;
+        o.inc = inc;
+        o.warp = NULL;
+        o.fold = NULL;
+        o.warpConst = 0.0f;
+        o.foldConst = 0.0f;
+        o.feedback = 0.55f;
+        o.feedbackAverage = average;
+        o.foldType = 0;
+        o.warpMode = four::WARP_NAIVE;
+        o.warpTables = NULL;
+        o.foldHistory = NULL;
+        four::Phase phase = 0;
+        four::FeedbackHistory prev = {};
+        for ( int pass = 0; pass < 2; ++pass )  // the first settles
+            for ( int i = 0; i < len; i += four::BLOCK_SIZE )
+                four::render_operator_block( phase, prev, o, pm, out + i, four::BLOCK_SIZE );
+
+        static double mag[n * 2 + 1];
+        magnitude_spectrum( out, len, mag );
+        for ( int k = 1; k <= 8; ++k )
+            db[r][k] = 20.0 * log10( mag[bin * k] / len + 1e-12 );
+    }
+    double worst = 0.0;
+    for ( int k = 1; k <= 8; ++k )
+        worst = fmax( worst, fabs( db[1][k] - db[0][k] ) );
+    return worst;
+}
+
+TEST(averaged_feedback_sounds_the_same_oversampled)
+{
+    // Last-sample feedback at this amount rings at Nyquist and breaks up
+    // differently at each rate; the DX average stays within a couple of dB,
+    // the 1x loop's longer delay dulling only the upper harmonics
+    double last = feedback_rate_difference_db( 0.0f );
+    double averaged = feedback_rate_difference_db( 0.5f );
+    printf( "(1x vs 4x: last sample %.1f dB, DX average %.1f dB) ", last, averaged );
+    ASSERT( averaged < 2.5 );
+    ASSERT( last > averaged + 3.0 );
+}
+
+TEST(fold_adaa_aliases_less_than_plain_fold)
+{
+    // Full fold on a ~1.76 kHz sine; first-order ADAA buys a steady
+    // ~5-7 dB on every type without oversampling
+    for ( int type = 0; type < 3; ++type )
+    {
+        double plain = shape_alias_db( four::WARP_NAIVE, 0.0f, type, 1.0f, false );
+        double adaa = shape_alias_db( four::WARP_NAIVE, 0.0f, type, 1.0f, true );
+        ASSERT( adaa < plain - 4.5 );
+    }
+}
+
+// --- Parameter Smoothing ---
+
+TEST(block_ramp_ends_on_target)
+{
+    float dst[4];
+    four::block_ramp( dst, 0.0f, 1.0f, 4 );
+    ASSERT_NEAR( dst[0], 0.25f, 1e-6f );
+    ASSERT_NEAR( dst[3], 1.0f, 1e-6f );
+}
+
+TEST(smoothed_linear_reaches_target_in_time)
+{
+    four::SmoothedValue sv;
+    sv.reset( 0.0f );
+    sv.set( 1.0f, 0.01f );   // 10 ms
+    ASSERT( sv.moving() );
+    for ( int i = 0; i < 9; ++i )
+        sv.advance( 0.001f );
+    ASSERT( sv.moving() );
+    ASSERT_NEAR( sv.value, 0.9f, 1e-5f );
+    sv.advance( 0.001f );
+    ASSERT( !sv.moving() );
+    ASSERT( sv.value == 1.0f );
+}
+
+TEST(smoothed_one_pole_settles)
+{
+    four::SmoothedValue sv;
+    sv.onePole = true;
+    sv.reset( 1.0f );
+    sv.set( 2.0f, 0.01f );
+    sv.advance( 0.001f );
+    ASSERT_NEAR( sv.value, 1.1f, 1e-6f );
+    for ( int i = 0; i < 1000 && sv.moving(); ++i )
+        sv.advance( 0.001f );
+    ASSERT( !sv.moving() );
+    ASSERT( sv.value == 2.0f );
+}
+
+TEST(smoothed_zero_time_jumps)
+{
+    four::SmoothedValue sv;
+    sv.reset( 0.0f );
+    sv.set( 0.7f, 0.0f );
+    ASSERT( !sv.moving() );
+    ASSERT( sv.value == 0.7f );
+}
+
+TEST(smoothed_fill_at_rest_is_constant)
+{
+    four::SmoothedValue sv;
+    sv.reset( 0.3f );
+    float dst[8];
+    sv.fill( dst, 0.001f, 8 );
+    for ( int i = 0; i < 8; ++i )
+        ASSERT( dst[i] == 0.3f );
+
+    // Moving: ramp from the old value to the advanced one
+    sv.set( 1.3f, 0.002f );
+    sv.fill( dst, 0.001f, 8 );
+    ASSERT_NEAR( dst[7], 0.8f, 1e-6f );
+    ASSERT( dst[0] > 0.3f && dst[0] < dst[7] );
+}
+
+// --- Block Rendering ---
+
+TEST(block_fill_and_cv_expand)
+{
+    float dst[8];
+    four::block_fill( dst, 0.25f, 8 );
+    ASSERT_NEAR( dst[7], 0.25f, 1e-9f );
+
+    // 2 frames at 2× → 4 sub-samples, each frame value repeated
+    const float cv[2] = { 1.0f, 10.0f };
+    four::block_fill( dst, 0.5f, 4 );
+    four::block_add_cv_clamped( dst, cv, 2, 2, 0.2f );
+    ASSERT_NEAR( dst[0], 0.7f, 1e-6f );
+    ASSERT_NEAR( dst[1], 0.7f, 1e-6f );
+    ASSERT_NEAR( dst[2], 1.0f, 1e-6f );   // clamped
+    ASSERT_NEAR( dst[3], 1.0f, 1e-6f );
+}
+
+// Block renderer must match the per-sample path for every algorithm
+static void check_block_matches_scalar( int warpMode )
+{
+    for ( int a = 0; a < 11; ++a )
+    {
+        static four::BlockScratch sb, ss;
+        four::AlgorithmBlock bb, bs;
+        four::Phase phaseB[4] = { 0, 0, 0, 0 }, phaseS[4] = { 0, 0, 0, 0 };
+        four::FeedbackHistory prevB[4] = {}, prevS[4] = {};
+
+        for ( int blk = 0; blk < 40; ++blk )
+        {
+            fill_patch_block( sb, bb, four::BLOCK_SIZE, warpMode, blk );
+            fill_patch_block( ss, bs, four::BLOCK_SIZE, warpMode, blk );
+            four::render_algorithm_block( four::algorithms[a], phaseB, prevB, bb, sb.opOut, sb.mix );
+            render_algorithm_scalar( four::algorithms[a], phaseS, prevS, bs, ss.mix );
+            for ( int i = 0; i < four::BLOCK_SIZE; ++i )
+                ASSERT_NEAR( sb.mix[i], ss.mix[i], 1e-4f );
+        }
+    }
+}
+
+TEST(block_matches_scalar)
+{
+    check_block_matches_scalar( four::WARP_NAIVE );
+}
+
+TEST(block_matches_scalar_polyblep)
+{
+    check_block_matches_scalar( four::WARP_POLYBLEP );
+}
+
+TEST(block_matches_scalar_wavetable)
+{
+    check_block_matches_scalar( four::WARP_TABLE );
+}
+
+TEST(block_partial_length)
+{
+    // Short final blocks render only n sub-samples
+    static four::BlockScratch s;
+    four::AlgorithmBlock b;
+    four::Phase phase[4] = { 0, 0, 0, 0 };
+    four::FeedbackHistory prev[4] = {};
+    fill_patch_block( s, b, 5, four::WARP_NAIVE, 0 );
+    s.mix[5] = 123.0f;
+    four::render_algorithm_block( four::algorithms[7], phase, prev, b, s.opOut, s.mix );
+    ASSERT_NEAR( s.mix[5], 123.0f, 1e-9f );
+    ASSERT( phase[0] > 0 );
+}
+
+// --- Per-Algorithm Renderers ---
+
+TEST(fixed_renderer_matches_block)
+{
+    for ( int a = 0; a < 11; ++a )
+    {
+        for ( int mode = 0; mode <= four::WARP_TABLE; ++mode )
+        {
+            static four::BlockScratch sg, sf;
+            four::AlgorithmBlock bg, bf;
+            four::Phase phaseG[4] = { 0, 0, 0, 0 }, phaseF[4] = { 0, 0, 0, 0 };
+            four::FeedbackHistory prevG[4] = {}, prevF[4] = {};
+            four::AlgorithmRenderer render = four::select_renderer( a, mode );
+
+            for ( int blk = 0; blk < 10; ++blk )
+            {
+                fill_patch_block( sg, bg, four::BLOCK_SIZE, mode, blk );
+                fill_patch_block( sf, bf, four::BLOCK_SIZE, mode, blk );
+                four::render_algorithm_block( four::algorithms[a], phaseG, prevG, bg, sg.opOut, sg.mix );
+                render( phaseF, prevF, bf, sf.opOut, sf.mix );
+                for ( int i = 0; i < four::BLOCK_SIZE; ++i )
+                    ASSERT( sg.mix[i] == sf.mix[i] );
+            }
+        }
+    }
+}
+
+// --- Profiling ---
+
+TEST(cpu_meter_window)
+{
+    four::CpuMeter m;
+    m.publish();                       // empty window keeps zeros
+    ASSERT( m.avg == 0.0f );
+    m.add( 3200, 32 );                 // 100 per sample
+    m.add( 6400, 32 );                 // 200
+    m.add( 1600, 32 );                 // 50
+    ASSERT( m.avg == 0.0f );           // nothing until published
+    m.publish();
+    ASSERT_NEAR( m.min, 50.0f, 1e-4f );
+    ASSERT_NEAR( m.max, 200.0f, 1e-4f );
+    ASSERT_NEAR( m.avg, 350.0f / 3.0f, 1e-3f );
+
+    // The next window starts fresh
+    m.add( 2400, 24 );
+    m.publish();
+    ASSERT_NEAR( m.min, 100.0f, 1e-4f );
+    ASSERT_NEAR( m.max, 100.0f, 1e-4f );
+}
+
+// --- Event queues ---
+
+TEST(event_ring_partial_release)
+{
+    four::EventRing<int, 4> r;
+    ASSERT( r.pending() == 0 );
+    for ( int i = 0; i < 4; ++i )
+        ASSERT( r.push( i ) );
+    ASSERT( !r.push( 4 ) );
+    ASSERT( r.pending() == 4 );
+    r.release( 3 );
+    ASSERT( r.pending() == 1 && r[0] == 3 );
+    ASSERT( r.push( 5 ) && r.push( 6 ) && r.push( 7 ) );  // wraps
+    ASSERT( r.pending() == 4 && r[1] == 5 && r[3] == 7 );
+}
+
+struct RecordParams
+{
+    int* log;
+    int* count;
+    void operator()( int param, int16_t value ) { log[(*count)++] = param * 1000 + value; }
+};
+
+TEST(param_queue_coalesces_in_last_update_order)
+{
+    four::ParamQueue<8> q;
+    int log[8], count = 0;
+    RecordParams rec = { log, &count };
+    ASSERT( q.drain( rec ) == 0 );
+
+    q.push( 5, 1 );
+    q.push( 7, 2 );
+    q.push( 5, 3 );
+    q.push( 200, 4 );
+    q.push( 7, 5 );
+    ASSERT( q.drain( rec ) == 3 );
+    ASSERT( count == 3 );
+    ASSERT( log[0] == 5003 );     // param 5's last update came first
+    ASSERT( log[1] == 200004 );
+    ASSERT( log[2] == 7005 );
+    ASSERT( q.coalesced == 2 );
+    ASSERT( q.spilled == 0 );
+
+    count = 0;
+    ASSERT( q.drain( rec ) == 0 );  // drained queue stays empty
+}
+
+TEST(param_queue_overflow_keeps_latest_and_wraps)
+{
+    four::ParamQueue<4> q;
+    int log[8], count = 0;
+    RecordParams rec = { log, &count };
+    for ( int i = 0; i < 4; ++i )
+        ASSERT( q.push( i, (int16_t)i ) );
+    ASSERT( !q.push( 9, 9 ) );
+    ASSERT( !q.push( 2, 20 ) );
+    ASSERT( !q.push( 9, 90 ) );
+    ASSERT( q.spilled == 3 );
+    ASSERT( q.drain( rec ) == 5 );
+    ASSERT( log[0] == 0 && log[1] == 1001 && log[2] == 3003 );  // param 2 overflowed
+    ASSERT( log[3] == 2020 );                                   // overflow last, by index
+    ASSERT( log[4] == 9090 );
+    ASSERT( q.coalesced == 1 );
+
+    // Overflow slots are cleared by the drain
+    count = 0;
+    ASSERT( q.drain( rec ) == 0 );
+
+    // Indices keep running past N
+    for ( int round = 0; round < 3; ++round )
+    {
+        count = 0;
+        q.push( 1, (int16_t)round );
+        q.push( 2, (int16_t)round );
+        q.push( 1, (int16_t)( round + 10 ) );
+        ASSERT( q.drain( rec ) == 2 );
+        ASSERT( log[0] == 2000 + round );
+        ASSERT( log[1] == 1010 + round );
+    }
+    ASSERT( q.coalesced == 4 );
+    ASSERT( q.spilled == 3 );
+}
+
+// --- Golden Output ---
+//
+// Every algorithm × fold type × pitch × PolyBLEP setting, rendered by the
+// optimized renderer and by the double-precision reference in reference.h,
+// compared as spectra. golden.h holds the reference's band levels so a
+// change to the reference itself (or to the routing table) also shows up;
+// regenerate it with `make golden` only when the sound is meant to change.
+
+static const int kGoldenN = 8192;
+static const int kGoldenBands = 8;
+static const double kGoldenPitches[3] = { 103.826, 415.305, 1661.219 };
+static const int kGoldenCases = 11 * 3 * 3 * 2;
+
+// Upper band edges in Hz; the last band runs to the sub-sample Nyquist
+static const double kGoldenBandEdges[kGoldenBands - 1] = { 250, 500, 1000, 2000, 4000, 8000, 16000 };
+
+static ReferencePatch golden_patch( int index, int& algorithm )
+{
+    algorithm = index / 18;
+    int foldType = index / 6 % 3;
+    int pitch = index / 2 % 3;
+    ReferencePatch p = {
+        kGoldenPitches[pitch], 96000.0,
+        { 1.0, 2.0, 3.0, 4.0 },
+        { 0.8, 0.7, 0.6, 0.5 },
+        { 0.0, 0.0, 0.1, 0.0 },
+        { 0.0, 0.5, 0.0, 0.8 },
+        { 0.4, 0.3, 0.0, 0.0 },
+        foldType, 0.5, ( index & 1 ) != 0
+    };
+    return p;
+}
+
+// Band energies relative to the total, in dB (floored at -120)
+static void golden_bands( const double* mag, double sampleRate, double* bands )
+{
+    double energy[kGoldenBands] = { 0.0 }, total = 1e-30;
+    for ( int k = 1; k <= kGoldenN / 2; ++k )
+    {
+        double hz = k * sampleRate / kGoldenN;
+        int band = 0;
+        while ( band < kGoldenBands - 1 && hz >= kGoldenBandEdges[band] )
+            ++band;
+        energy[band] += mag[k] * mag[k];
+        total += mag[k] * mag[k];
+    }
+    for ( int b = 0; b < kGoldenBands; ++b )
+        bands[b] = std::max( -120.0, 10.0 * log10( energy[b] / total + 1e-30 ) );
+}
+
+struct GoldenResult
+{
+    double spectralError;          // dB, |optimized| - |reference| vs |reference|
+    double bandError;              // dB, worst band above -80 dB
+    double bands[kGoldenBands];    // reference
+    double optimized[kGoldenBands];
+};
+
+static GoldenResult golden_case( int index )
+{
+    static double ref[kGoldenN], refMag[kGoldenN / 2 + 1], optMag[kGoldenN / 2 + 1];
+    static float opt[kGoldenN];
+    int a;
+    ReferencePatch p = golden_patch( index, a );
+    render_reference( four::algorithms[a], p, ref, kGoldenN );
+    render_optimized( a, p, opt, kGoldenN );
+    magnitude_spectrum( ref, kGoldenN, refMag );
+    magnitude_spectrum( opt, kGoldenN, optMag );
+
+    GoldenResult r;
+    double diff = 0.0, power = 1e-30;
+    for ( int k = 0; k <= kGoldenN / 2; ++k )
+    {
+        diff += ( optMag[k] - refMag[k] ) * ( optMag[k] - refMag[k] );
+        power += refMag[k] * refMag[k];
+    }
+    r.spectralError = 10.0 * log10( diff / power + 1e-30 );
+    golden_bands( refMag, p.sampleRate, r.bands );
+    golden_bands( optMag, p.sampleRate, r.optimized );
+    r.bandError = 0.0;
+    for ( int b = 0; b < kGoldenBands; ++b )
+        if ( r.bands[b] > -80.0 )
+            r.bandError = std::max( r.bandError, fabs( r.optimized[b] - r.bands[b] ) );
+    return r;
+}
+
+// Tolerances. Modulation, folding and warp edges amplify the sine table's
+// error by up to ~40 dB, so the whole-spectrum bound follows the table size.
+static double golden_spectral_tolerance()
+{
+    return 20.0 * log10( sine_table_bound() ) + 44.0;
+}
+static const double kGoldenBandTolerance = 0.1;     // dB, optimized vs reference
+static const double kGoldenStoredTolerance = 0.06;  // dB, 0.1 dB rounding in golden.h
+
+#include "golden.h"
+
+TEST(golden_spectra_match_reference)
+{
+    double worst = -200.0;
+    for ( int i = 0; i < kGoldenCases; ++i )
+    {
+        GoldenResult r = golden_case( i );
+        worst = std::max( worst, r.spectralError );
+        if ( r.spectralError > golden_spectral_tolerance() || r.bandError > kGoldenBandTolerance )
+        {
+            int a;
+            ReferencePatch p = golden_patch( i, a );
+            printf( "FAIL\n    algorithm %d, fold type %d, %.0f Hz, PolyBLEP %s: "
+                    "spectral error %.1f dB, band error %.3f dB\n",
+                    a + 1, p.foldType, p.hz, p.polyblep ? "on" : "off",
+                    r.spectralError, r.bandError );
+            exit( 1 );
+        }
+    }
+    printf( "(worst %.1f dB) ", worst );
+}
+
+TEST(golden_reference_matches_stored)
+{
+    for ( int i = 0; i < kGoldenCases; ++i )
+    {
+        GoldenResult r = golden_case( i );
+        for ( int b = 0; b < kGoldenBands; ++b )
+        {
+            double stored = goldenBands[i][b] * 0.1;
+            if ( stored > -80.0 || r.bands[b] > -80.0 )
+                ASSERT_NEAR( r.bands[b], stored, kGoldenStoredTolerance );
+        }
+    }
+}
+
+// Print golden.h from the reference
+static void write_golden()
+{
+    printf( "#ifndef FOUR_TESTS_GOLDEN_H\n#define FOUR_TESTS_GOLDEN_H\n\n" );
+    printf( "// Generated by `make golden` (test_dsp --golden). Band levels of the\n" );
+    printf( "// double-precision reference in 0.1 dB, one row per golden_patch() index.\n\n" );
+    printf( "static const int16_t goldenBands[%d][%d] = {\n", kGoldenCases, kGoldenBands );
+    for ( int i = 0; i < kGoldenCases; ++i )
+    {
+        GoldenResult r = golden_case( i );
+        printf( "    {" );
+        for ( int b = 0; b < kGoldenBands; ++b )
+            printf( " %5d%s", (int)lround( r.bands[b] * 10.0 ), b < kGoldenBands - 1 ? "," : "" );
+        printf( " },\n" );
+    }
+    printf( "};\n\n#endif // FOUR_TESTS_GOLDEN_H\n" );
+}
+
+TEST(operator_used)
+{
+    // Every operator in the shipped algorithms reaches the output
+    for ( int a = 0; a < 11; ++a )
+        for ( int op = 0; op < 4; ++op )
+            ASSERT( four::operator_used( a, op ) );
+
+    static_assert( four::operator_used( 7, 3 ), "algo 8: op4 is a carrier" );
+}
+
+// --- Voices ---
+
+TEST(allocate_voice_prefers_idle)
+{
+    uint8_t note[4] = { 60, 62, 64, 65 };
+    uint8_t gate[4] = { 1, 0, 1, 0 };
+    float amp[4]    = { 1.0f, 0.5f, 1.0f, 0.0f };
+    uint32_t age[4] = { 1, 2, 3, 4 };
+    // Voice 3 is released and silent
+    ASSERT( four::allocate_voice( 70, note, gate, amp, age, 4 ) == 3 );
+}
+
+TEST(allocate_voice_retriggers_same_note)
+{
+    uint8_t note[4] = { 60, 62, 64, 65 };
+    uint8_t gate[4] = { 1, 1, 1, 0 };
+    float amp[4]    = { 1.0f, 1.0f, 1.0f, 0.0f };
+    uint32_t age[4] = { 1, 2, 3, 4 };
+    ASSERT( four::allocate_voice( 64, note, gate, amp, age, 4 ) == 2 );
+}
+
+TEST(allocate_voice_steals_quietest_released)
+{
+    uint8_t note[4] = { 60, 62, 64, 65 };
+    uint8_t gate[4] = { 1, 0, 0, 1 };
+    float amp[4]    = { 1.0f, 0.6f, 0.2f, 1.0f };
+    uint32_t age[4] = { 1, 2, 3, 4 };
+    ASSERT( four::allocate_voice( 70, note, gate, amp, age, 4 ) == 2 );
+}
+
+TEST(allocate_voice_steals_oldest_held)
+{
+    uint8_t note[4] = { 60, 62, 64, 65 };
+    uint8_t gate[4] = { 1, 1, 1, 1 };
+    float amp[4]    = { 1.0f, 1.0f, 1.0f, 1.0f };
+    uint32_t age[4] = { 0xFFFFFFFEu, 0xFFFFFFFFu, 0, 1 };  // wrapped counter
+    ASSERT( four::allocate_voice( 70, note, gate, amp, age, 4 ) == 0 );
+}
+
+TEST(allocate_voice_mono)
+{
+    uint8_t note[1] = { 60 };
+    uint8_t gate[1] = { 1 };
+    float amp[1]    = { 0.0f };
+    uint32_t age[1] = { 5 };
+    ASSERT( four::allocate_voice( 72, note, gate, amp, age, 1 ) == 0 );
+}
+
+TEST(voice_ramp)
+{
+    four::VoiceRamp ramp( 1000.0f, 0.01f );  // 10 sub-samples full scale
+    float src[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    float dst[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    float amp = ramp.apply( dst, src, 0.0f, true, 4 );
+    ASSERT_NEAR( amp, 0.4f, 1e-6f );
+    ASSERT_NEAR( dst[0], 0.1f, 1e-6f );
+    ASSERT_NEAR( dst[3], 0.4f, 1e-6f );
+
+    // Release clamps at zero
+    amp = ramp.apply( dst, src, 0.2f, false, 4 );
+    ASSERT_NEAR( amp, 0.0f, 1e-9f );
+}
+
+TEST(voice_ramp_advance_matches_apply)
+{
+    four::VoiceRamp ramp( 48000.0f );
+    float src[64], dst[64];
+    for ( int i = 0; i < 64; ++i )
+        src[i] = dst[i] = 0.0f;
+    float amp = 0.3f;
+    for ( int g = 0; g < 2; ++g )
+    {
+        float skipped = amp;
+        for ( int b = 0; b < 2; ++b )
+        {
+            amp = ramp.apply( dst, src, amp, g == 0, 64 );
+            skipped = ramp.advance( skipped, g == 0, 64 );
+            ASSERT( skipped == amp );
+        }
+    }
+    ASSERT_NEAR( amp, 0.3f, 1e-5f );  // up 128 sub-samples, back down 128
+}
+
 // --- Runner ---
 
-int main()
+int main( int argc, char** argv )
 {
+    four::init_sine_table();
+
+    if ( argc > 1 && strcmp( argv[1], "--golden" ) == 0 )
+    {
+        write_golden();
+        return 0;
+    }
+
     printf("Four DSP tests:\n");
 
     run_placeholder();
@@ -391,11 +1682,24 @@ int main()
     run_oscillator_sine_half();
     run_phase_advance();
     run_phase_advance_wraps();
+    run_phase_step_drops_whole_cycles();
+    run_phase_accumulator_holds_pitch_for_minutes();
+    run_phase_advance_runs_backwards();
+    run_sync_phase_advance_resets_and_reports_wraps();
+    run_sync_edges_land_between_frames();
+    run_hard_sync_blep_aliases_less_than_naive_reset();
+    run_hard_sync_feedback_history_follows_blep();
+    run_averaged_feedback_sounds_the_same_oversampled();
+    run_sine_table_error_bound();
+    run_sine_table_thd();
+    run_fold_uses_table_within_bound();
     run_freq_ratio_mode();
     run_freq_ratio_with_fine();
     run_freq_fixed_mode();
     run_voct_to_freq();
     run_midi_note_to_freq();
+    run_fast_exp2_accuracy();
+    run_operator_tuning_ratio_and_fixed();
     run_warp_zero_is_passthrough();
     run_warp_triangle();
     run_warp_saw();
@@ -405,9 +1709,13 @@ int main()
     run_fold_symmetric_stays_bounded();
     run_fold_asymmetric_stays_bounded();
     run_fold_softclip_stays_bounded();
+    run_fold_adaa_is_segment_mean();
+    run_fold_adaa_short_segment_tends_to_fold();
+    run_fold_adaa_zero_amount_tracks_input();
     run_feedback_zero_amount();
     run_feedback_full_amount();
     run_feedback_is_bounded();
+    run_feedback_averages_last_two_outputs();
     run_algorithm_1_serial_chain();
     run_algorithm_5_two_pairs();
     run_algorithm_8_all_carriers();
@@ -417,10 +1725,48 @@ int main()
     run_algorithm_9_serial_split();
     run_algorithm_10_parallel_to_pair();
     run_algorithm_11_three_to_one();
-    run_downsample_2x();
+    run_decimator_iir_stopband();
+    run_decimator_fir_stopband();
+    run_decimator_passband();
+    run_decimator_fir_is_linear_phase();
+    run_auto_oversampling_pure_sines_stay_at_1x();
+    run_auto_oversampling_follows_modulation();
+    run_auto_oversampling_shaping_raises_risk();
+    run_auto_oversampling_keeps_feedback_clean();
+    run_choose_oversampling_thresholds();
     run_polyblep_correction_near_zero();
     run_polyblep_correction_far_from_edge();
     run_polyblep_saw_reduces_aliasing();
+    run_warp_tables_match_fourier_series();
+    run_warp_table_level_stays_below_nyquist();
+    run_wavetable_warp_aliases_less_than_polyblep();
+    run_reversed_operator_aliases_like_forward();
+    run_fold_adaa_aliases_less_than_plain_fold();
+    run_block_ramp_ends_on_target();
+    run_smoothed_linear_reaches_target_in_time();
+    run_smoothed_one_pole_settles();
+    run_smoothed_zero_time_jumps();
+    run_smoothed_fill_at_rest_is_constant();
+    run_block_fill_and_cv_expand();
+    run_block_matches_scalar();
+    run_block_matches_scalar_polyblep();
+    run_block_matches_scalar_wavetable();
+    run_block_partial_length();
+    run_fixed_renderer_matches_block();
+    run_cpu_meter_window();
+    run_event_ring_partial_release();
+    run_param_queue_coalesces_in_last_update_order();
+    run_param_queue_overflow_keeps_latest_and_wraps();
+    run_golden_spectra_match_reference();
+    run_golden_reference_matches_stored();
+    run_operator_used();
+    run_allocate_voice_prefers_idle();
+    run_allocate_voice_retriggers_same_note();
+    run_allocate_voice_steals_quietest_released();
+    run_allocate_voice_steals_oldest_held();
+    run_allocate_voice_mono();
+    run_voice_ramp();
+    run_voice_ramp_advance_matches_apply();
 
     printf("\n%d/%d tests passed.\n", tests_passed, tests_run);
     return 0;